@@ -0,0 +1,1159 @@
+// SPDX-License-Identifier: MIT
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <time.h>
+
+#include "nanogl.h"
+#include "nanogl/batch.h"
+#include "nanogl/cache.h"
+#include "nanogl/driver_memory.h"
+#include "nanogl/executor_posix.h"
+#include "nanogl/profile.h"
+#include "nanogl/rectangle.h"
+
+#include "draw/pixel.h"
+#include "st7789_convert.h"
+
+#ifdef BENCH_FREETYPE
+#include "font_render.h"
+#endif
+
+
+#define WIDGETS_MAX 64
+#define BATCH_SIZE 256
+#define SPRITE_SIZE 48
+#define PROFILE_RECORDS 65536
+#define TEXT_SIZES 4
+#define FONT_POOL_SIZE (128 * 1024)
+#define FONT_CACHE_SIZE 64
+/* Horizontal scroll of FreeType text in pixels */
+#define FONT_SCROLL 16
+
+
+/* Widget drawing pixmap placed at its area */
+typedef struct bench_sprite {
+	ngl_buffer_t pixmap;
+	ngl_color_t color;
+} bench_sprite_t;
+
+/* Line of glyph masks, every glyph has own source buffer valid for display list */
+typedef struct bench_text {
+	ngl_buffer_t *glyphs;
+	size_t count;
+	ngl_color_t color;
+} bench_text_t;
+
+/* Gradient converted to RGB565 by dithering of ST7789 driver at start of every frame */
+typedef struct bench_dither {
+	ngl_color_t *gradient;
+	st7789_color_t *pixels;
+	ngl_buffer_t pixmap;
+} bench_dither_t;
+
+/* Widgets of scene, storage of all scenes is same */
+typedef struct bench_scene {
+	ngl_widget_t *roots[WIDGETS_MAX];
+	size_t root_count;
+	ngl_widget_t widgets[WIDGETS_MAX];
+	size_t widget_count;
+	ngl_widget_rectangle_data_t colors[WIDGETS_MAX];
+	bench_sprite_t sprites[WIDGETS_MAX];
+	/* Velocity of moving widgets */
+	int dx[WIDGETS_MAX];
+	int dy[WIDGETS_MAX];
+	ngl_widget_t *children[WIDGETS_MAX];
+	ngl_batch_t batch;
+	ngl_area_t batch_areas[BATCH_SIZE];
+	ngl_color_t batch_colors[BATCH_SIZE];
+	int batch_dx[BATCH_SIZE];
+	int batch_dy[BATCH_SIZE];
+	ngl_surface_cache_t surface_cache;
+	ngl_widget_cache_t widget_cache;
+	ngl_byte_t *rgba_pixels;
+	ngl_byte_t *mask_pixels;
+	bench_text_t texts[TEXT_SIZES];
+	ngl_byte_t *glyph_pixels[TEXT_SIZES];
+	bench_dither_t dither;
+#ifdef BENCH_FREETYPE
+	void *font_data;
+	font_face_t font_face;
+	font_render_t font_renders[TEXT_SIZES];
+	/* Top of lines for font_place_glyph */
+	int font_lines[TEXT_SIZES];
+#endif
+	uint32_t random;
+} bench_scene_t;
+
+typedef void (*bench_setup_fn) (ngl_driver_t *driver, bench_scene_t *scene);
+typedef void (*bench_update_fn) (ngl_driver_t *driver, bench_scene_t *scene, size_t frame);
+
+/* Scripted scene, update is called before every frame */
+typedef struct bench_scene_def {
+	const char *name;
+	const char *description;
+	bench_setup_fn setup;
+	bench_update_fn update;
+	/* Pixels depend on installed library, scene runs only when selected by --scene */
+	bool optional;
+} bench_scene_def_t;
+
+typedef struct bench_config {
+	int width;
+	int height;
+	ngl_color_format_t format;
+	int band_lines;
+	bool windows;
+	size_t frames;
+	size_t warmup;
+	size_t threads;
+	size_t display_list;
+	const char *scene;
+	/* Print profiler summary of every scene */
+	bool profile;
+	/* Print drawing statistics of every scene */
+	bool stats;
+	/* File of Chrome trace of single scene */
+	const char *trace;
+	/* Directory for last frames of scenes */
+	const char *dump;
+	/* Directory of reference images compared to last frames */
+	const char *compare;
+	/* Maximal difference of color channel */
+	int tolerance;
+} bench_config_t;
+
+/* Band timing collected by wrapped driver functions */
+typedef struct bench_timing {
+	ngl_driver_get_buffer_fn get_buffer;
+	ngl_driver_get_window_fn get_window;
+	ngl_driver_flush_fn flush;
+	int64_t band_start;
+	int64_t *bands;
+	size_t band_count;
+	size_t band_capacity;
+} bench_timing_t;
+
+
+static bench_timing_t timing;
+
+#ifdef BENCH_FREETYPE
+static uint8_t font_library_storage[FONT_LIBRARY_STORAGE_SIZE(FONT_POOL_SIZE)];
+static uint8_t font_face_storage[FONT_FACE_STORAGE_SIZE];
+static uint8_t font_render_storage[TEXT_SIZES][FONT_RENDER_STORAGE_SIZE(FONT_CACHE_SIZE)];
+static const char font_text[TEXT_SIZES][32] = {"Sphinx of black quartz", "judge my vow! 0123456789", "Pack my box with", "five jugs"};
+#endif
+
+#ifdef NGL_PROFILE
+static ngl_profile_record_t profile_records[PROFILE_RECORDS];
+static ngl_profiler_t profiler;
+#endif
+
+
+static int64_t bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static ngl_buffer_t *bench_get_buffer(ngl_driver_t *driver) {
+	timing.band_start = bench_now();
+	return timing.get_buffer(driver);
+}
+
+
+static ngl_buffer_t *bench_get_window(ngl_driver_t *driver, ngl_area_t *area) {
+	timing.band_start = bench_now();
+	return timing.get_window(driver, area);
+}
+
+
+static void bench_flush(ngl_driver_t *driver) {
+	timing.flush(driver);
+	if (timing.band_count == timing.band_capacity) {
+		timing.band_capacity = timing.band_capacity ? timing.band_capacity * 2 : 1024;
+		timing.bands = (int64_t *)realloc(timing.bands, timing.band_capacity * sizeof(int64_t));
+	}
+	timing.bands[timing.band_count++] = bench_now() - timing.band_start;
+}
+
+
+static void bench_timing_attach(ngl_driver_t *driver) {
+	timing.get_buffer = driver->get_buffer;
+	timing.get_window = driver->get_window;
+	timing.flush = driver->flush;
+	driver->get_buffer = bench_get_buffer;
+	driver->get_window = driver->get_window == NULL ? NULL : bench_get_window;
+	driver->flush = bench_flush;
+	timing.band_count = 0;
+}
+
+
+/* Deterministic generator, every run draws same frames */
+static uint32_t bench_random(bench_scene_t *scene, uint32_t range) {
+	scene->random = scene->random * 1664525 + 1013904223;
+	return (scene->random >> 8) % range;
+}
+
+
+static ngl_color_t bench_random_color(bench_scene_t *scene, uint8_t alpha) {
+	ngl_color_t color;
+	color.rgba.r = bench_random(scene, 256);
+	color.rgba.g = bench_random(scene, 256);
+	color.rgba.b = bench_random(scene, 256);
+	color.rgba.a = alpha;
+	return color;
+}
+
+
+static ngl_area_t bench_random_area(ngl_driver_t *driver, bench_scene_t *scene, int width, int height) {
+	width = width < driver->width ? width : driver->width;
+	height = height < driver->height ? height : driver->height;
+	ngl_area_t area = {
+		.x = bench_random(scene, driver->width - width + 1),
+		.y = bench_random(scene, driver->height - height + 1),
+		.width = width,
+		.height = height,
+	};
+	return area;
+}
+
+
+static ngl_widget_t *bench_add_rectangle(ngl_driver_t *driver, bench_scene_t *scene, ngl_area_t *area, ngl_color_t color, bool root) {
+	const size_t index = scene->widget_count++;
+	ngl_widget_t *widget = &scene->widgets[index];
+	ngl_widget_init(driver, widget, ngl_widget_rectangle, area, &scene->colors[index], &color.rgba);
+	scene->dx[index] = (int)bench_random(scene, 7) - 3;
+	scene->dy[index] = (int)bench_random(scene, 7) - 3;
+	if (root) {
+		scene->roots[scene->root_count++] = widget;
+	}
+	return widget;
+}
+
+
+static void bench_add_background(ngl_driver_t *driver, bench_scene_t *scene) {
+	ngl_area_t area = {0, 0, driver->width, driver->height};
+	bench_add_rectangle(driver, scene, &area, (ngl_color_t){.rgba = {32, 32, 48, 255}}, true);
+}
+
+
+/* Move widget by its velocity, bouncing from screen edges */
+static void bench_move(ngl_driver_t *driver, bench_scene_t *scene, size_t index) {
+	ngl_widget_t *widget = &scene->widgets[index];
+	ngl_area_t area = widget->area;
+	area.x += scene->dx[index];
+	area.y += scene->dy[index];
+	if (area.x < 0 || area.x + area.width > driver->width) {
+		scene->dx[index] = -scene->dx[index];
+		area.x = widget->area.x;
+	}
+	if (area.y < 0 || area.y + area.height > driver->height) {
+		scene->dy[index] = -scene->dy[index];
+		area.y = widget->area.y;
+	}
+	ngl_widget_reshape(driver, widget, area);
+}
+
+
+static void bench_sprite_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	bench_sprite_t *sprite = (bench_sprite_t *)widget->priv;
+	ngl_draw_pixmap(buffer, &sprite->pixmap, NULL, sprite->color);
+}
+
+
+static void bench_sprite_reshape(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t *area) {
+	bench_sprite_t *sprite = (bench_sprite_t *)widget->priv;
+	ngl_buffer_init(&sprite->pixmap, area, sprite->pixmap.buffer, sprite->pixmap.format, driver);
+}
+
+
+static void bench_sprite(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
+	static ngl_widget_event_table_t event_table = {
+		.draw = bench_sprite_draw,
+		.reshape = bench_sprite_reshape
+	};
+	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
+}
+
+
+static void bench_add_sprite(ngl_driver_t *driver, bench_scene_t *scene, ngl_byte_t *pixels, ngl_color_format_t format, ngl_color_t color) {
+	const size_t index = scene->widget_count++;
+	ngl_area_t area = bench_random_area(driver, scene, SPRITE_SIZE, SPRITE_SIZE);
+	bench_sprite_t *sprite = &scene->sprites[index];
+	ngl_buffer_init(&sprite->pixmap, &area, pixels, format, driver);
+	sprite->color = color;
+	ngl_widget_init(driver, &scene->widgets[index], bench_sprite, &area, sprite, NULL);
+	scene->dx[index] = (int)bench_random(scene, 9) - 4;
+	scene->dy[index] = (int)bench_random(scene, 9) - 4;
+	scene->roots[scene->root_count++] = &scene->widgets[index];
+}
+
+
+static void bench_text_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	bench_text_t *text = (bench_text_t *)widget->priv;
+	for (size_t i = 0; i < text->count; ++i) {
+		if (ngl_area_intersects(&text->glyphs[i].area, &buffer->clip)) {
+			ngl_draw_pixmap(buffer, &text->glyphs[i], NULL, text->color);
+		}
+	}
+}
+
+
+static void bench_text(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
+	static ngl_widget_event_table_t event_table = {
+		.draw = bench_text_draw
+	};
+	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
+}
+
+
+/* Opaque rectangles covering screen, every frame changes colors */
+static void bench_fill_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	bench_add_background(driver, scene);
+	for (size_t i = 0; i < 15; ++i) {
+		ngl_area_t area = bench_random_area(driver, scene, driver->width / 3, driver->height / 3);
+		bench_add_rectangle(driver, scene, &area, bench_random_color(scene, 255), true);
+	}
+}
+
+
+static void bench_fill_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	for (size_t i = 0; i < scene->widget_count; ++i) {
+		scene->colors[i] = bench_random_color(scene, 255);
+	}
+	ngl_invalidate(driver);
+}
+
+
+/* Large overlapping translucent rectangles */
+static void bench_blend_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	bench_add_background(driver, scene);
+	for (size_t i = 0; i < 32; ++i) {
+		ngl_area_t area = bench_random_area(driver, scene, driver->width / 2, driver->height / 2);
+		bench_add_rectangle(driver, scene, &area, bench_random_color(scene, 64 + bench_random(scene, 128)), true);
+	}
+}
+
+
+static void bench_blend_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	ngl_invalidate(driver);
+}
+
+
+/* Moving RGBA sprites and gray masks */
+static void bench_pixmap_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	scene->rgba_pixels = (ngl_byte_t *)malloc(SPRITE_SIZE * SPRITE_SIZE * sizeof(ngl_color_t));
+	scene->mask_pixels = (ngl_byte_t *)malloc(SPRITE_SIZE * SPRITE_SIZE);
+	ngl_color_t *rgba = (ngl_color_t *)scene->rgba_pixels;
+	const int center = SPRITE_SIZE / 2;
+	for (int y = 0; y < SPRITE_SIZE; ++y) {
+		for (int x = 0; x < SPRITE_SIZE; ++x) {
+			const int distance = (x - center) * (x - center) + (y - center) * (y - center);
+			const int alpha = distance >= center * center ? 0 : 255 - distance * 255 / (center * center);
+			rgba[y * SPRITE_SIZE + x].rgba = (ngl_rgba_t){x * 255 / SPRITE_SIZE, y * 255 / SPRITE_SIZE, 128, alpha};
+			scene->mask_pixels[y * SPRITE_SIZE + x] = alpha;
+		}
+	}
+
+	bench_add_background(driver, scene);
+	for (size_t i = 0; i < 8; ++i) {
+		bench_add_sprite(driver, scene, scene->rgba_pixels, NGL_RGBA, (ngl_color_t){.value = 0xffffffff});
+		bench_add_sprite(driver, scene, scene->mask_pixels, NGL_GRAY_8, bench_random_color(scene, 255));
+	}
+}
+
+
+/* Rows of glyph like masks of several sizes, every frame changes color of text */
+static void bench_text_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	static const int sizes[TEXT_SIZES] = {8, 12, 16, 24};
+	static const ngl_color_format_t formats[TEXT_SIZES] = {NGL_MONO, NGL_GRAY_2, NGL_GRAY_2, NGL_GRAY_2};
+
+	bench_add_background(driver, scene);
+	int y = 2;
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		const int size = sizes[i];
+		const unsigned short bits = ngl_get_color_bits(formats[i]);
+
+		// Ring with stem, edges use lower levels of gray
+		scene->glyph_pixels[i] = (ngl_byte_t *)calloc((size * size * bits + 7) >> 3, 1);
+		const int radius = size * size / 4;
+		for (int py = 0; py < size; ++py) {
+			for (int px = 0; px < size; ++px) {
+				const int distance = (2 * px - size + 1) * (2 * px - size + 1) / 4 + (2 * py - size + 1) * (2 * py - size + 1) / 4;
+				uint8_t value = 0;
+				if ((distance < radius && distance > radius / 3) || (px > size / 2 && px < size / 2 + size / 6 + 1)) {
+					value = 255;
+				}
+				else if (distance < radius + size / 2) {
+					value = 128;
+				}
+				ngl_pixel_store(formats[i], scene->glyph_pixels[i], py * size + px, ngl_color_from_gray(value));
+			}
+		}
+
+		// Two lines of glyphs
+		const size_t columns = driver->width / size;
+		bench_text_t *text = &scene->texts[i];
+		text->glyphs = (ngl_buffer_t *)malloc(columns * 2 * sizeof(ngl_buffer_t));
+		text->count = 0;
+		text->color = bench_random_color(scene, 255);
+		ngl_area_t text_area = {0, y, columns * size, 0};
+		for (int line = 0; line < 2 && y + size <= driver->height; ++line) {
+			for (size_t column = 0; column < columns; ++column) {
+				ngl_area_t area = {column * size, y, size, size};
+				ngl_buffer_init(&text->glyphs[text->count++], &area, scene->glyph_pixels[i], formats[i], driver);
+			}
+			y += size + 2;
+			text_area.height = y - text_area.y;
+		}
+		ngl_widget_t *widget = &scene->widgets[scene->widget_count++];
+		ngl_widget_init(driver, widget, bench_text, &text_area, text, NULL);
+		scene->roots[scene->root_count++] = widget;
+	}
+}
+
+
+static void bench_text_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		scene->texts[i].color = bench_random_color(scene, 255);
+	}
+	ngl_invalidate(driver);
+}
+
+
+static void bench_move_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	// Background doesn't move
+	for (size_t i = 1; i < scene->widget_count; ++i) {
+		bench_move(driver, scene, i);
+	}
+}
+
+
+/* Small moving rectangles, only dirty areas are redrawn */
+static void bench_move_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	bench_add_background(driver, scene);
+	for (size_t i = 0; i < 24; ++i) {
+		ngl_area_t area = bench_random_area(driver, scene, 16 + bench_random(scene, 32), 16 + bench_random(scene, 32));
+		bench_add_rectangle(driver, scene, &area, bench_random_color(scene, i & 1 ? 255 : 160), true);
+	}
+}
+
+
+/* Many rectangles in single batch widget, part of them moves every frame */
+static void bench_batch_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	bench_add_background(driver, scene);
+	ngl_widget_t *widget = &scene->widgets[scene->widget_count++];
+	ngl_batch_init(driver, widget, &scene->batch, ngl_widget_rectangle_batch_draw, scene->batch_areas, scene->batch_colors, sizeof(ngl_color_t), BATCH_SIZE);
+	for (size_t i = 0; i < BATCH_SIZE; ++i) {
+		ngl_area_t area = bench_random_area(driver, scene, 8, 8);
+		const int index = ngl_batch_add(driver, widget, &area);
+		scene->batch_colors[index] = bench_random_color(scene, 255);
+		scene->batch_dx[index] = (int)bench_random(scene, 5) - 2;
+		scene->batch_dy[index] = (int)bench_random(scene, 5) - 2;
+	}
+	scene->roots[scene->root_count++] = widget;
+}
+
+
+static void bench_batch_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	ngl_widget_t *widget = scene->roots[1];
+	for (size_t i = frame % 8; i < BATCH_SIZE; i += 8) {
+		ngl_area_t area = scene->batch_areas[i];
+		area.x += scene->batch_dx[i];
+		area.y += scene->batch_dy[i];
+		if (area.x < 0 || area.x + area.width > driver->width) {
+			scene->batch_dx[i] = -scene->batch_dx[i];
+			area.x = scene->batch_areas[i].x;
+		}
+		if (area.y < 0 || area.y + area.height > driver->height) {
+			scene->batch_dy[i] = -scene->batch_dy[i];
+			area.y = scene->batch_areas[i].y;
+		}
+		ngl_batch_set_area(driver, widget, i, &area);
+	}
+}
+
+
+/* Panel of translucent rectangles drawn from cached surface under moving rectangle */
+static void bench_cache_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	bench_add_background(driver, scene);
+
+	ngl_area_t panel_area = {driver->width / 8, driver->height / 8, driver->width * 3 / 4, driver->height * 3 / 4};
+	ngl_surface_cache_init(&scene->surface_cache, (size_t)panel_area.width * panel_area.height * sizeof(ngl_color_t), 0);
+	ngl_widget_t *panel = &scene->widgets[scene->widget_count++];
+	ngl_widget_cache_init(driver, panel, &scene->widget_cache, &scene->surface_cache, NGL_RGBA, &panel_area);
+
+	size_t child_count = 0;
+	scene->children[child_count++] = bench_add_rectangle(driver, scene, &panel_area, (ngl_color_t){.rgba = {200, 200, 200, 255}}, false);
+	for (size_t i = 0; i < 40; ++i) {
+		ngl_area_t area = {
+			.x = panel_area.x + bench_random(scene, panel_area.width - panel_area.width / 4),
+			.y = panel_area.y + bench_random(scene, panel_area.height - panel_area.height / 4),
+			.width = panel_area.width / 4,
+			.height = panel_area.height / 4,
+		};
+		scene->children[child_count++] = bench_add_rectangle(driver, scene, &area, bench_random_color(scene, 128), false);
+	}
+	ngl_widget_set_children(driver, panel, scene->children, child_count);
+	scene->roots[scene->root_count++] = panel;
+
+	ngl_area_t area = bench_random_area(driver, scene, 24, 24);
+	bench_add_rectangle(driver, scene, &area, (ngl_color_t){.rgba = {255, 64, 64, 255}}, true);
+	scene->dx[scene->widget_count - 1] = 3;
+	scene->dy[scene->widget_count - 1] = 2;
+}
+
+
+static void bench_cache_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	bench_move(driver, scene, scene->widget_count - 1);
+	// Occasional change of panel renders surface again
+	if (frame % 32 == 31) {
+		const size_t index = 3 + bench_random(scene, 40);
+		scene->colors[index] = bench_random_color(scene, 128);
+		ngl_widget_invalidate(driver, &scene->widgets[index]);
+	}
+}
+
+
+static void bench_dither_frame_start(ngl_driver_t *driver, ngl_widget_t *widget) {
+	bench_dither_t *dither = (bench_dither_t *)widget->priv;
+	// Same noise every frame keeps reference image independent of frame count
+	st7789_convert_dither_seed(0x12345678);
+	st7789_convert_dither(dither->gradient, dither->pixels, (size_t)widget->area.width * widget->area.height);
+}
+
+
+static void bench_dither_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	bench_dither_t *dither = (bench_dither_t *)widget->priv;
+	ngl_draw_pixmap(buffer, &dither->pixmap, NULL, (ngl_color_t){.value = 0xffffffff});
+}
+
+
+static void bench_dither(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
+	static ngl_widget_event_table_t event_table = {
+		.draw = bench_dither_draw,
+		.frame_start = bench_dither_frame_start
+	};
+	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
+}
+
+
+/* Smooth gradient of whole screen dithered to RGB565, gradient scrolls every frame */
+static void bench_dither_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	ngl_area_t area = {0, 0, driver->width, driver->height};
+	const size_t count = (size_t)area.width * area.height;
+	scene->dither.gradient = (ngl_color_t *)malloc(count * sizeof(ngl_color_t));
+	scene->dither.pixels = (st7789_color_t *)malloc(count * sizeof(st7789_color_t));
+	ngl_buffer_init(&scene->dither.pixmap, &area, (ngl_byte_t *)scene->dither.pixels, NGL_RGB_565, driver);
+	ngl_widget_t *widget = &scene->widgets[scene->widget_count++];
+	ngl_widget_init(driver, widget, bench_dither, &area, &scene->dither, NULL);
+	scene->roots[scene->root_count++] = widget;
+}
+
+
+static void bench_dither_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	const int width = driver->width;
+	const int height = driver->height;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			// Slopes lower than one step of RGB565 per pixel show banding without dithering
+			const int position = (x + (int)frame) % width;
+			scene->dither.gradient[y * width + x].rgba = (ngl_rgba_t){position * 64 / width + 96, y * 48 / height + 64, (position + y) * 32 / (width + height) + 128, 255};
+		}
+	}
+	ngl_invalidate(driver);
+}
+
+
+#ifdef BENCH_FREETYPE
+static ngl_area_t bench_glyph_area(font_glyph_placement_t *placement) {
+	return (ngl_area_t){placement->area.x, placement->area.y, placement->area.width, placement->area.height};
+}
+
+
+/* Place glyphs of every line shifted by offset, bitmaps stay same */
+static void bench_freetype_place(ngl_driver_t *driver, bench_scene_t *scene, int offset) {
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		bench_text_t *text = &scene->texts[i];
+		font_pos_t pos = {offset, scene->font_lines[i]};
+		font_glyph_placement_t placement;
+		for (size_t j = 0; j < text->count; ++j) {
+			placement = font_place_glyph(&scene->font_renders[i], (unsigned char)font_text[i][j], &pos, j > 0 ? &placement : NULL);
+			ngl_area_t area = bench_glyph_area(&placement);
+			ngl_buffer_init(&text->glyphs[j], &area, text->glyphs[j].buffer, NGL_GRAY_8, driver);
+			pos.x += placement.advance.x;
+		}
+	}
+}
+
+
+/* Lines of Ubuntu font of four pixel sizes placed by font_place_glyph, text scrolls and changes color every frame */
+static void bench_freetype_setup(ngl_driver_t *driver, bench_scene_t *scene) {
+	static const unsigned int sizes[TEXT_SIZES] = {11, 14, 18, 26};
+
+	bench_add_background(driver, scene);
+	FILE *file = fopen(BENCH_FONT, "rb");
+	if (file == NULL) {
+		perror(BENCH_FONT);
+		return;
+	}
+	fseek(file, 0, SEEK_END);
+	const size_t size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	scene->font_data = malloc(size);
+	const bool loaded = fread(scene->font_data, 1, size, file) == size;
+	fclose(file);
+	if (!loaded || font_library_init_static(font_library_storage, sizeof(font_library_storage)) != ESP_OK || font_face_init_static(&scene->font_face, scene->font_data, size, font_face_storage, sizeof(font_face_storage)) != ESP_OK) {
+		fprintf(stderr, "Font %s not loaded\n", BENCH_FONT);
+		return;
+	}
+
+	int y = 4;
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		font_render_t *render = &scene->font_renders[i];
+		if (font_render_init_static(render, &scene->font_face, sizes[i], FONT_CACHE_SIZE, font_render_storage[i], sizeof(font_render_storage[i])) != ESP_OK) {
+			return;
+		}
+
+		// Glyphs fitting to line at largest scroll, bitmaps share one block
+		scene->font_lines[i] = y;
+		const size_t length = strlen(font_text[i]);
+		font_glyph_placement_t placements[sizeof(font_text[i])];
+		font_pos_t pos = {0, y};
+		ngl_area_t text_area = {0, y, FONT_SCROLL, font_get_line_height(render)};
+		size_t count = 0;
+		size_t pixels = 0;
+		for (; count < length; ++count) {
+			placements[count] = font_place_glyph(render, (unsigned char)font_text[i][count], &pos, count > 0 ? &placements[count - 1] : NULL);
+			if (placements[count].area.x + placements[count].area.width + FONT_SCROLL > driver->width) {
+				break;
+			}
+			ngl_area_t area = bench_glyph_area(&placements[count]);
+			ngl_area_union(&text_area, &area, &text_area);
+			pos.x += placements[count].advance.x;
+			pixels += (size_t)placements[count].area.width * placements[count].area.height;
+		}
+		text_area.width += FONT_SCROLL;
+
+		bench_text_t *text = &scene->texts[i];
+		text->glyphs = (ngl_buffer_t *)malloc(count * sizeof(ngl_buffer_t));
+		text->count = count;
+		text->color = bench_random_color(scene, 255);
+		scene->glyph_pixels[i] = (ngl_byte_t *)malloc(pixels + 1);
+		ngl_byte_t *bitmap = scene->glyph_pixels[i];
+		for (size_t j = 0; j < count; ++j) {
+			if (font_render_glyph(render, &placements[j], bitmap, placements[j].area.width) != ESP_OK) {
+				fprintf(stderr, "Glyph %c not rendered\n", font_text[i][j]);
+			}
+			ngl_area_t area = bench_glyph_area(&placements[j]);
+			ngl_buffer_init(&text->glyphs[j], &area, bitmap, NGL_GRAY_8, driver);
+			bitmap += placements[j].area.width * placements[j].area.height;
+		}
+
+		ngl_widget_t *widget = &scene->widgets[scene->widget_count++];
+		ngl_widget_init(driver, widget, bench_text, &text_area, text, NULL);
+		scene->roots[scene->root_count++] = widget;
+		y += text_area.height + 4;
+	}
+}
+
+
+static void bench_freetype_update(ngl_driver_t *driver, bench_scene_t *scene, size_t frame) {
+	if (scene->root_count != TEXT_SIZES + 1) {
+		return;
+	}
+	// Triangle wave keeps text inside its widget
+	const int phase = frame % (2 * FONT_SCROLL);
+	bench_freetype_place(driver, scene, phase < FONT_SCROLL ? phase : 2 * FONT_SCROLL - phase);
+	bench_text_update(driver, scene, frame);
+}
+#endif
+
+
+static const bench_scene_def_t scenes[] = {
+	{"fill", "opaque rectangles, whole screen every frame", bench_fill_setup, bench_fill_update},
+	{"blend", "translucent rectangles, whole screen every frame", bench_blend_setup, bench_blend_update},
+	{"pixmap", "moving RGBA sprites and gray masks", bench_pixmap_setup, bench_move_update},
+	{"text", "mono and gray2 glyph masks of four sizes", bench_text_setup, bench_text_update},
+	{"move", "moving small rectangles", bench_move_setup, bench_move_update},
+	{"batch", "batch of rectangles, eighth moves every frame", bench_batch_setup, bench_batch_update},
+	{"cache", "cached panel under moving rectangle", bench_cache_setup, bench_cache_update},
+	{"dither", "gradient dithered to RGB565 by ST7789 conversion", bench_dither_setup, bench_dither_update},
+#ifdef BENCH_FREETYPE
+	{"freetype", "Ubuntu glyphs of four sizes placed by font_place_glyph", bench_freetype_setup, bench_freetype_update, true},
+#endif
+};
+
+
+static const char *format_names[] = {"mono", "gray2", "gray8", "rgb565", "rgb888", "rgba"};
+
+/* Maximal median frame time of scenes in microseconds, 0 is unlimited */
+static double budgets[sizeof(scenes) / sizeof(scenes[0])];
+
+
+static const bench_scene_def_t *bench_find_scene(const char *name) {
+	for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+		if (strcmp(name, scenes[i].name) == 0) {
+			return &scenes[i];
+		}
+	}
+	return NULL;
+}
+
+
+static void bench_scene_destroy(bench_scene_t *scene) {
+	ngl_surface_cache_destroy(&scene->surface_cache);
+	free(scene->rgba_pixels);
+	free(scene->mask_pixels);
+	free(scene->dither.gradient);
+	free(scene->dither.pixels);
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		free(scene->texts[i].glyphs);
+		free(scene->glyph_pixels[i]);
+	}
+#ifdef BENCH_FREETYPE
+	for (size_t i = 0; i < TEXT_SIZES; ++i) {
+		font_render_destroy(&scene->font_renders[i]);
+	}
+	font_face_destroy(&scene->font_face);
+	font_library_destroy();
+	free(scene->font_data);
+#endif
+}
+
+
+static int bench_compare(const void *a, const void *b) {
+	const int64_t x = *(const int64_t *)a;
+	const int64_t y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+
+/* Nearest rank percentile of sorted values in microseconds */
+static double bench_percentile(int64_t *values, size_t count, unsigned int percent) {
+	if (count == 0) {
+		return 0;
+	}
+	return values[(count - 1) * percent / 100] / 1000.0;
+}
+
+
+static double bench_mean(int64_t *values, size_t count) {
+	if (count == 0) {
+		return 0;
+	}
+	double sum = 0;
+	for (size_t i = 0; i < count; ++i) {
+		sum += values[i];
+	}
+	return sum / count / 1000.0;
+}
+
+
+/* Reference image of scene for current screen size and format */
+static void bench_image_path(bench_config_t *config, const char *directory, const bench_scene_def_t *def, char *path, size_t size) {
+	snprintf(path, size, "%s/%s_%s_%dx%d.ppm", directory, def->name, format_names[config->format], config->width, config->height);
+}
+
+
+/* Write framebuffer as binary PPM */
+static bool bench_write_image(ngl_buffer_t *framebuffer, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", framebuffer->area.width, framebuffer->area.height);
+	for (int y = 0; y < framebuffer->area.height; ++y) {
+		for (int x = 0; x < framebuffer->area.width; ++x) {
+			const ngl_color_t color = ngl_pixel_load(framebuffer->format, framebuffer->buffer, y * framebuffer->stride + x);
+			fputc(color.rgba.r, file);
+			fputc(color.rgba.g, file);
+			fputc(color.rgba.b, file);
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+
+/* Compare framebuffer with PPM image, returns false if it can't be read or pixels differ more than tolerance */
+static bool bench_compare_image(ngl_buffer_t *framebuffer, const char *path, int tolerance) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+	int width;
+	int height;
+	int max_value;
+	if (fscanf(file, "P6 %d %d %d", &width, &height, &max_value) != 3 || max_value != 255 || fgetc(file) == EOF) {
+		fprintf(stderr, "%s: not binary PPM\n", path);
+		fclose(file);
+		return false;
+	}
+	if (width != framebuffer->area.width || height != framebuffer->area.height) {
+		fprintf(stderr, "%s: size %dx%d differs\n", path, width, height);
+		fclose(file);
+		return false;
+	}
+
+	size_t differ = 0;
+	int max_difference = 0;
+	int first_x = -1;
+	int first_y = -1;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			const ngl_color_t color = ngl_pixel_load(framebuffer->format, framebuffer->buffer, y * framebuffer->stride + x);
+			const int channels[3] = {color.rgba.r, color.rgba.g, color.rgba.b};
+			int difference = 0;
+			for (size_t i = 0; i < 3; ++i) {
+				const int reference = fgetc(file);
+				if (reference == EOF) {
+					fprintf(stderr, "%s: truncated\n", path);
+					fclose(file);
+					return false;
+				}
+				difference = MAX(difference, abs(reference - channels[i]));
+			}
+			if (difference > tolerance) {
+				if (differ++ == 0) {
+					first_x = x;
+					first_y = y;
+				}
+			}
+			max_difference = MAX(max_difference, difference);
+		}
+	}
+	fclose(file);
+
+	if (differ > 0) {
+		fprintf(stderr, "%s: %zu pixels differ, first at %d,%d, maximal difference %d\n", path, differ, first_x, first_y, max_difference);
+		return false;
+	}
+	return true;
+}
+
+
+static bool bench_run_scene(bench_config_t *config, const bench_scene_def_t *def, ngl_executor_t *executor, ngl_command_t *commands) {
+	ngl_driver_t driver;
+	ngl_memory_driver_init_struct_t driver_config = {
+		.width = config->width,
+		.height = config->height,
+		.format = config->format,
+		.band_lines = config->band_lines,
+		.windows = config->windows,
+		.framebuffer = NULL,
+	};
+	if (!ngl_memory_driver_init(&driver, &driver_config)) {
+		fprintf(stderr, "Framebuffer not allocated\n");
+		return false;
+	}
+	ngl_display_list_t display_list;
+	if (commands != NULL) {
+		ngl_display_list_init(&display_list, commands, config->display_list);
+		driver.display_list = &display_list;
+	}
+	driver.executor = executor;
+	bench_timing_attach(&driver);
+#ifdef NGL_PROFILE
+	driver.profiler = &profiler;
+#endif
+
+	bench_scene_t *scene = (bench_scene_t *)calloc(1, sizeof(bench_scene_t));
+	scene->random = 1;
+	def->setup(&driver, scene);
+
+	int64_t *frames = (int64_t *)malloc(config->frames * sizeof(int64_t));
+	for (size_t frame = 0; frame < config->warmup + config->frames; ++frame) {
+		if (frame == config->warmup) {
+			timing.band_count = 0;
+			memset(ngl_memory_driver_stats(&driver), 0, sizeof(ngl_memory_driver_stats_t));
+			memset(&driver.stats, 0, sizeof(ngl_stats_t));
+#ifdef NGL_PROFILE
+			ngl_profiler_clear(&profiler);
+#endif
+		}
+		def->update(&driver, scene, frame);
+		const int64_t start = bench_now();
+		ngl_draw_frame(&driver, scene->roots, scene->root_count);
+		if (frame >= config->warmup) {
+			frames[frame - config->warmup] = bench_now() - start;
+		}
+	}
+
+	bool result = true;
+	const double mean = bench_mean(frames, config->frames);
+	const double band_mean = bench_mean(timing.bands, timing.band_count);
+	qsort(frames, config->frames, sizeof(int64_t), bench_compare);
+	qsort(timing.bands, timing.band_count, sizeof(int64_t), bench_compare);
+	const ngl_memory_driver_stats_t *stats = ngl_memory_driver_stats(&driver);
+	printf(
+		"%-8s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %7.1f %9.2f\n",
+		def->name,
+		mean,
+		bench_percentile(frames, config->frames, 50),
+		bench_percentile(frames, config->frames, 90),
+		bench_percentile(frames, config->frames, 99),
+		bench_percentile(frames, config->frames, 100),
+		band_mean,
+		bench_percentile(timing.bands, timing.band_count, 99),
+		(double)stats->bands / config->frames,
+		mean > 0 ? stats->pixels / (mean * config->frames) : 0
+	);
+
+	if (config->stats) {
+		ngl_stats_t draw_stats;
+		ngl_get_stats(&driver, &draw_stats);
+		printf(
+			"         frames %u skipped %u bands %u lines_skipped %u cache_hits %u cache_misses %u\n",
+			draw_stats.frames,
+			draw_stats.frames_skipped,
+			draw_stats.bands,
+			draw_stats.lines_skipped,
+			draw_stats.cache_hits,
+			draw_stats.cache_misses
+		);
+	}
+
+	const double median = bench_percentile(frames, config->frames, 50);
+	const double budget = budgets[def - scenes];
+	if (budget > 0 && median > budget) {
+		fprintf(stderr, "%s: median frame time %.1f us over budget %.1f us\n", def->name, median, budget);
+		result = false;
+	}
+
+	char path[512];
+	ngl_buffer_t *framebuffer = ngl_memory_driver_framebuffer(&driver);
+	if (config->dump != NULL) {
+		bench_image_path(config, config->dump, def, path, sizeof(path));
+		result = bench_write_image(framebuffer, path) && result;
+	}
+	if (config->compare != NULL) {
+		bench_image_path(config, config->compare, def, path, sizeof(path));
+		result = bench_compare_image(framebuffer, path, config->tolerance) && result;
+	}
+
+#ifdef NGL_PROFILE
+	if (config->profile) {
+		ngl_profiler_write_summary(&profiler, stdout);
+		printf("\n");
+	}
+	if (config->trace != NULL) {
+		FILE *trace = fopen(config->trace, "w");
+		if (trace == NULL) {
+			perror(config->trace);
+		}
+		else {
+			ngl_profiler_write_trace(&profiler, trace);
+			fclose(trace);
+		}
+	}
+#endif
+
+	free(frames);
+	bench_scene_destroy(scene);
+	free(scene);
+	ngl_memory_driver_destroy(&driver);
+	return result;
+}
+
+
+static bool bench_parse_format(const char *name, ngl_color_format_t *format) {
+	for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); ++i) {
+		if (strcmp(name, format_names[i]) == 0) {
+			*format = (ngl_color_format_t)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/* Parse budget of all scenes or NAME=US for single scene */
+static bool bench_parse_budget(const char *text) {
+	const char *value = strchr(text, '=');
+	if (value == NULL) {
+		for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+			budgets[i] = atof(text);
+		}
+		return true;
+	}
+	for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+		if (strlen(scenes[i].name) == (size_t)(value - text) && strncmp(text, scenes[i].name, value - text) == 0) {
+			budgets[i] = atof(value + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+static void bench_usage(const char *program) {
+	printf(
+		"Usage: %s [options]\n"
+		"  --width N          screen width (240)\n"
+		"  --height N         screen height (240)\n"
+		"  --format NAME      mono, gray2, gray8, rgb565, rgb888 or rgba (rgb565)\n"
+		"  --band-lines N     lines of band, 0 is whole screen (24)\n"
+		"  --no-windows       redraw whole screen instead of dirty windows\n"
+		"  --frames N         measured frames (500)\n"
+		"  --warmup N         frames drawn before measurement (20)\n"
+		"  --scene NAME       run only single scene\n"
+		"  --display-list N   record frame to display list of N commands\n"
+		"  --threads N        render display list tiles on N workers\n"
+		"  --dump DIR         write last frame of scenes as PPM images\n"
+		"  --compare DIR      compare last frame of scenes with images written by --dump\n"
+		"  --tolerance N      allowed difference of color channel (0)\n"
+		"  --budget [NAME=]US fail if median frame time of scene exceeds budget\n"
+		"  --stats            print frame, band and cache counters of every scene\n"
+#ifdef NGL_PROFILE
+		"  --profile          print time of widget events, bands and flushes\n"
+		"  --trace FILE       write Chrome trace of scene selected by --scene\n"
+#endif
+		"\nScenes:\n",
+		program
+	);
+	for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+		printf("  %-8s %s%s\n", scenes[i].name, scenes[i].description, scenes[i].optional ? " (only with --scene)" : "");
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	bench_config_t config = {
+		.width = 240,
+		.height = 240,
+		.format = NGL_RGB_565,
+		.band_lines = 24,
+		.windows = true,
+		.frames = 500,
+		.warmup = 20,
+		.threads = 0,
+		.display_list = 0,
+		.scene = NULL,
+		.profile = false,
+		.stats = false,
+		.trace = NULL,
+		.dump = NULL,
+		.compare = NULL,
+		.tolerance = 0,
+	};
+
+	enum {OPT_WIDTH = 256, OPT_HEIGHT, OPT_FORMAT, OPT_BAND_LINES, OPT_NO_WINDOWS, OPT_FRAMES, OPT_WARMUP, OPT_SCENE, OPT_DISPLAY_LIST, OPT_THREADS, OPT_PROFILE, OPT_TRACE, OPT_DUMP, OPT_COMPARE, OPT_TOLERANCE, OPT_BUDGET, OPT_STATS, OPT_HELP};
+	static const struct option options[] = {
+		{"width", required_argument, NULL, OPT_WIDTH},
+		{"height", required_argument, NULL, OPT_HEIGHT},
+		{"format", required_argument, NULL, OPT_FORMAT},
+		{"band-lines", required_argument, NULL, OPT_BAND_LINES},
+		{"no-windows", no_argument, NULL, OPT_NO_WINDOWS},
+		{"frames", required_argument, NULL, OPT_FRAMES},
+		{"warmup", required_argument, NULL, OPT_WARMUP},
+		{"scene", required_argument, NULL, OPT_SCENE},
+		{"display-list", required_argument, NULL, OPT_DISPLAY_LIST},
+		{"threads", required_argument, NULL, OPT_THREADS},
+		{"dump", required_argument, NULL, OPT_DUMP},
+		{"compare", required_argument, NULL, OPT_COMPARE},
+		{"tolerance", required_argument, NULL, OPT_TOLERANCE},
+		{"budget", required_argument, NULL, OPT_BUDGET},
+		{"stats", no_argument, NULL, OPT_STATS},
+#ifdef NGL_PROFILE
+		{"profile", no_argument, NULL, OPT_PROFILE},
+		{"trace", required_argument, NULL, OPT_TRACE},
+#endif
+		{"help", no_argument, NULL, OPT_HELP},
+		{NULL, 0, NULL, 0}
+	};
+
+	int option;
+	while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+		switch (option) {
+			case OPT_WIDTH: config.width = atoi(optarg); break;
+			case OPT_HEIGHT: config.height = atoi(optarg); break;
+			case OPT_FORMAT:
+				if (!bench_parse_format(optarg, &config.format)) {
+					fprintf(stderr, "Unknown format %s\n", optarg);
+					return 1;
+				}
+				break;
+			case OPT_BAND_LINES: config.band_lines = atoi(optarg); break;
+			case OPT_NO_WINDOWS: config.windows = false; break;
+			case OPT_FRAMES: config.frames = strtoul(optarg, NULL, 10); break;
+			case OPT_WARMUP: config.warmup = strtoul(optarg, NULL, 10); break;
+			case OPT_SCENE: config.scene = optarg; break;
+			case OPT_DISPLAY_LIST: config.display_list = strtoul(optarg, NULL, 10); break;
+			case OPT_THREADS: config.threads = strtoul(optarg, NULL, 10); break;
+			case OPT_PROFILE: config.profile = true; break;
+			case OPT_TRACE: config.trace = optarg; break;
+			case OPT_DUMP: config.dump = optarg; break;
+			case OPT_COMPARE: config.compare = optarg; break;
+			case OPT_TOLERANCE: config.tolerance = atoi(optarg); break;
+			case OPT_BUDGET:
+				if (!bench_parse_budget(optarg)) {
+					fprintf(stderr, "Unknown scene in budget %s\n", optarg);
+					return 1;
+				}
+				break;
+			case OPT_STATS: config.stats = true; break;
+			case OPT_HELP: bench_usage(argv[0]); return 0;
+			default: bench_usage(argv[0]); return 1;
+		}
+	}
+	if (config.width <= 0 || config.height <= 0 || config.frames == 0) {
+		fprintf(stderr, "Invalid screen size or frame count\n");
+		return 1;
+	}
+	if (config.scene != NULL && bench_find_scene(config.scene) == NULL) {
+		fprintf(stderr, "Unknown scene %s\n", config.scene);
+		return 1;
+	}
+	if (config.trace != NULL && config.scene == NULL) {
+		fprintf(stderr, "Trace needs single scene\n");
+		return 1;
+	}
+
+	ngl_command_t *commands = NULL;
+	if (config.display_list > 0) {
+		commands = (ngl_command_t *)malloc(config.display_list * sizeof(ngl_command_t));
+	}
+#ifdef NGL_PROFILE
+	ngl_profiler_init(&profiler, profile_records, PROFILE_RECORDS);
+#endif
+	ngl_executor_t executor;
+	bool has_executor = config.threads > 0 && ngl_posix_executor_init(&executor, config.threads);
+
+	printf(
+		"# %dx%d %s, band %d lines, %s, display list %zu, threads %zu, %zu frames\n",
+		config.width,
+		config.height,
+		format_names[config.format],
+		config.band_lines,
+		config.windows ? "windows" : "whole screen",
+		config.display_list,
+		has_executor ? config.threads : 0,
+		config.frames
+	);
+	printf("%-8s %9s %9s %9s %9s %9s %9s %9s %7s %9s\n", "scene", "mean_us", "p50_us", "p90_us", "p99_us", "max_us", "band_us", "band_p99", "bands", "mpix_s");
+
+	int result = 0;
+	for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+		if (config.scene == NULL ? scenes[i].optional : strcmp(config.scene, scenes[i].name) != 0) {
+			continue;
+		}
+		// Every scene runs even if previous failed
+		if (!bench_run_scene(&config, &scenes[i], has_executor ? &executor : NULL, commands)) {
+			result = 1;
+		}
+	}
+
+	if (has_executor) {
+		ngl_posix_executor_destroy(&executor);
+	}
+	free(commands);
+	free(timing.bands);
+	return result;
+}
@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: MIT
+// Subset of ESP-IDF used by components built on host for benchmarks
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DEFAULT 0
+#define MALLOC_CAP_DMA 0
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_free(ptr) free(ptr)
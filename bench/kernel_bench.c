@@ -0,0 +1,529 @@
+// SPDX-License-Identifier: MIT
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nanogl.h"
+#include "font_cache.h"
+#include "st7789_convert.h"
+
+#ifdef BENCH_FREETYPE
+#include "font_render.h"
+#endif
+
+
+#define REPEAT_MAX 64
+#define RESULTS_MAX 1024
+#define FONT_CACHE_ITEM 24
+#define FONT_CACHE_ITEMS 64
+#define FONT_POOL_SIZE (64 * 1024)
+
+
+typedef void (*kernel_fn) (void *data);
+
+/* Single measured case, unit is amount of work per call */
+typedef struct kernel_case {
+	const char *kernel;
+	char variant[32];
+	int width;
+	int height;
+	int offset;
+	const char *unit;
+	size_t units;
+} kernel_case_t;
+
+typedef struct kernel_result {
+	kernel_case_t test;
+	size_t iterations;
+	/* Nanoseconds per call */
+	double best;
+	double median;
+} kernel_result_t;
+
+typedef struct kernel_config {
+	/* Duration of every measured run in nanoseconds */
+	int64_t run_time;
+	unsigned int repeat;
+	const char *filter;
+	const char *json;
+	const char *font;
+} kernel_config_t;
+
+/* Arguments of kernels, every group uses own part */
+typedef struct kernel_data {
+	ngl_buffer_t target;
+	ngl_buffer_t source;
+	ngl_area_t area;
+	ngl_color_t color;
+	const ngl_color_t *rgba;
+	st7789_color_t *rgb565;
+	uint8_t *gray2;
+	size_t count;
+	font_cache_t *cache;
+	font_cache_glyph_t glyph;
+	font_cache_glyph_t glyph_count;
+#ifdef BENCH_FREETYPE
+	font_render_t *render;
+	font_utf_code_t code;
+#endif
+} kernel_data_t;
+
+
+static kernel_config_t config;
+static kernel_result_t results[RESULTS_MAX];
+#ifdef BENCH_FREETYPE
+// FreeType allocates from pool like on device
+static uint8_t font_library_storage[FONT_LIBRARY_STORAGE_SIZE(FONT_POOL_SIZE)];
+static uint8_t font_face_storage[FONT_FACE_STORAGE_SIZE];
+#endif
+static size_t result_count;
+static uint32_t random_state = 1;
+
+static const char *format_names[] = {"mono", "gray2", "gray8", "rgb565", "rgb888", "rgba"};
+/* Sizes of drawn area, glyph, line, band and screen */
+static const ngl_area_t sizes[] = {{0, 0, 16, 16}, {0, 0, 240, 1}, {0, 0, 240, 20}, {0, 0, 240, 240}};
+/* Pixels from aligned start, packed and RGB565 formats do not start at word boundary */
+static const int offsets[] = {0, 1, 3};
+
+
+static int64_t kernel_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static uint8_t kernel_random_byte(void) {
+	random_state = random_state * 1664525 + 1013904223;
+	return random_state >> 24;
+}
+
+
+static void *kernel_random_alloc(size_t size) {
+	uint8_t *data = (uint8_t *)malloc(size);
+	for (size_t i = 0; i < size; ++i) {
+		data[i] = kernel_random_byte();
+	}
+	return data;
+}
+
+
+static size_t kernel_format_size(ngl_color_format_t format, size_t pixels) {
+	return (pixels * ngl_get_color_bits(format) + 7) >> 3;
+}
+
+
+static int kernel_compare(const void *a, const void *b) {
+	const double x = *(const double *)a;
+	const double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+
+static double kernel_run(kernel_fn fn, void *data, size_t iterations) {
+	const int64_t start = kernel_now();
+	for (size_t i = 0; i < iterations; ++i) {
+		fn(data);
+	}
+	return (double)(kernel_now() - start);
+}
+
+
+/* Measure case unless filtered out, iterations grow until run is long enough for clock */
+static void kernel_measure(const kernel_case_t *test, kernel_fn fn, void *data) {
+	char name[96];
+	snprintf(name, sizeof(name), "%s/%s", test->kernel, test->variant);
+	if (config.filter != NULL && strstr(name, config.filter) == NULL) {
+		return;
+	}
+	if (result_count == RESULTS_MAX) {
+		fprintf(stderr, "Too many results, %s skipped\n", name);
+		return;
+	}
+
+	size_t iterations = 1;
+	while (kernel_run(fn, data, iterations) < config.run_time && iterations < ((size_t)1 << 40)) {
+		iterations *= 2;
+	}
+
+	double times[REPEAT_MAX];
+	for (unsigned int i = 0; i < config.repeat; ++i) {
+		times[i] = kernel_run(fn, data, iterations) / iterations;
+	}
+	qsort(times, config.repeat, sizeof(double), kernel_compare);
+
+	kernel_result_t *result = &results[result_count++];
+	result->test = *test;
+	result->iterations = iterations;
+	result->best = times[0];
+	result->median = times[config.repeat / 2];
+
+	if (config.json == NULL || strcmp(config.json, "-") != 0) {
+		printf(
+			"%-8s %-20s %4dx%-4d %3d %10.1f %10.1f %10.2f\n",
+			test->kernel,
+			test->variant,
+			test->width,
+			test->height,
+			test->offset,
+			result->best,
+			result->median,
+			test->units / result->best * 1000.0
+		);
+	}
+}
+
+
+static void kernel_fill(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	ngl_fill_area(&kernel->target, &kernel->area, kernel->color);
+}
+
+
+static void kernel_blit(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	ngl_draw_pixmap(&kernel->target, &kernel->source, &kernel->area, kernel->color);
+}
+
+
+static void kernel_convert_simple(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	st7789_convert_simple(kernel->rgba, kernel->rgb565, kernel->count);
+}
+
+
+static void kernel_convert_dither(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	st7789_convert_dither(kernel->rgba, kernel->rgb565, kernel->count);
+}
+
+
+static void kernel_gray2(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	st7789_draw_gray2_bitmap(kernel->gray2, kernel->rgb565, 255, 128, 0, kernel->area.x, kernel->area.y, kernel->area.width, kernel->area.height, 240, 240);
+}
+
+
+static void kernel_font_cache(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	bool found;
+	font_cache_get(kernel->cache, kernel->glyph, &found);
+	kernel->glyph = kernel->glyph + 1 < kernel->glyph_count ? kernel->glyph + 1 : 0;
+}
+
+
+#ifdef BENCH_FREETYPE
+static void kernel_font_place(void *data) {
+	kernel_data_t *kernel = (kernel_data_t *)data;
+	font_pos_t pos = {0, 0};
+	font_place_glyph(kernel->render, kernel->code, &pos, NULL);
+	// Printable ASCII
+	kernel->code = kernel->code < 126 ? kernel->code + 1 : 33;
+}
+#endif
+
+
+/* Opaque and translucent fills of every target format */
+static void kernel_bench_fill(void) {
+	for (size_t format = 0; format < sizeof(format_names) / sizeof(format_names[0]); ++format) {
+		for (int blend = 0; blend < 2; ++blend) {
+			for (size_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); ++size) {
+				for (size_t offset = 0; offset < sizeof(offsets) / sizeof(offsets[0]); ++offset) {
+					// Wider buffer keeps fill from being single continuous block
+					ngl_area_t buffer_area = {0, 0, sizes[size].width + 8, sizes[size].height};
+					ngl_byte_t *pixels = (ngl_byte_t *)kernel_random_alloc(kernel_format_size(format, buffer_area.width * buffer_area.height));
+					kernel_data_t data = {
+						.area = {offsets[offset], 0, sizes[size].width, sizes[size].height},
+						.color = {.rgba = {.r = 200, .g = 100, .b = 50, .a = blend ? 128 : 255}},
+					};
+					ngl_buffer_init(&data.target, &buffer_area, pixels, format, NULL);
+
+					kernel_case_t test = {"fill", "", data.area.width, data.area.height, offsets[offset], "pixels", data.area.width * data.area.height};
+					snprintf(test.variant, sizeof(test.variant), "%s_%s", format_names[format], blend ? "blend" : "opaque");
+					kernel_measure(&test, kernel_fill, &data);
+					free(pixels);
+				}
+			}
+		}
+	}
+}
+
+
+/* Pixmaps of every format to formats of display bands, masks are glyph blending */
+static void kernel_bench_blit(void) {
+	static const ngl_color_format_t targets[] = {NGL_RGB_565, NGL_RGBA};
+	for (size_t target = 0; target < sizeof(targets) / sizeof(targets[0]); ++target) {
+		for (size_t format = 0; format < sizeof(format_names) / sizeof(format_names[0]); ++format) {
+			for (size_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); ++size) {
+				for (size_t offset = 0; offset < sizeof(offsets) / sizeof(offsets[0]); ++offset) {
+					// Source starts at same offset as target
+					ngl_area_t buffer_area = {0, 0, sizes[size].width + 8, sizes[size].height};
+					ngl_byte_t *target_pixels = (ngl_byte_t *)kernel_random_alloc(kernel_format_size(targets[target], buffer_area.width * buffer_area.height));
+					ngl_byte_t *source_pixels = (ngl_byte_t *)kernel_random_alloc(kernel_format_size(format, buffer_area.width * buffer_area.height));
+					kernel_data_t data = {
+						.area = {offsets[offset], 0, sizes[size].width, sizes[size].height},
+						.color = {.value = 0xffffffff},
+					};
+					if (format <= NGL_GRAY_8) {
+						data.color.rgba.g = 0;
+					}
+					ngl_buffer_init(&data.target, &buffer_area, target_pixels, targets[target], NULL);
+					ngl_buffer_init(&data.source, &buffer_area, source_pixels, format, NULL);
+
+					kernel_case_t test = {"blit", "", data.area.width, data.area.height, offsets[offset], "pixels", data.area.width * data.area.height};
+					snprintf(test.variant, sizeof(test.variant), "%s_%s", format_names[format], format_names[targets[target]]);
+					kernel_measure(&test, kernel_blit, &data);
+					free(target_pixels);
+					free(source_pixels);
+				}
+			}
+		}
+	}
+}
+
+
+/* RGBA band to RGB565, offset is number of pixels over multiple of 4 handled by scalar tail */
+static void kernel_bench_convert(void) {
+	for (int dither = 0; dither < 2; ++dither) {
+		for (size_t size = 0; size < sizeof(sizes) / sizeof(sizes[0]); ++size) {
+			for (size_t offset = 0; offset < sizeof(offsets) / sizeof(offsets[0]); ++offset) {
+				kernel_data_t data = {
+					.count = sizes[size].width * sizes[size].height + offsets[offset],
+				};
+				data.rgba = (const ngl_color_t *)kernel_random_alloc(data.count * sizeof(ngl_color_t));
+				data.rgb565 = (st7789_color_t *)malloc(data.count * sizeof(st7789_color_t));
+
+				kernel_case_t test = {"convert", "", sizes[size].width, sizes[size].height, offsets[offset], "pixels", data.count};
+				snprintf(test.variant, sizeof(test.variant), "%s", dither ? "dither" : "simple");
+				kernel_measure(&test, dither ? kernel_convert_dither : kernel_convert_simple, &data);
+				free((void *)data.rgba);
+				free(data.rgb565);
+			}
+		}
+	}
+}
+
+
+/* Gray2 glyphs blended to RGB565 screen */
+static void kernel_bench_gray2(void) {
+	static const int glyph_sizes[] = {8, 16, 24, 48};
+	st7789_color_t *screen = (st7789_color_t *)kernel_random_alloc(240 * 240 * sizeof(st7789_color_t));
+	for (size_t size = 0; size < sizeof(glyph_sizes) / sizeof(glyph_sizes[0]); ++size) {
+		for (size_t offset = 0; offset < sizeof(offsets) / sizeof(offsets[0]); ++offset) {
+			const int glyph_size = glyph_sizes[size];
+			kernel_data_t data = {
+				.area = {offsets[offset], 0, glyph_size, glyph_size},
+				.rgb565 = screen,
+			};
+			data.gray2 = (uint8_t *)kernel_random_alloc((glyph_size * glyph_size + 3) >> 2);
+
+			kernel_case_t test = {"gray2", "rgb565", glyph_size, glyph_size, offsets[offset], "pixels", glyph_size * glyph_size};
+			kernel_measure(&test, kernel_gray2, &data);
+			free(data.gray2);
+		}
+	}
+	free(screen);
+}
+
+
+/* Lookup of glyphs in cache which fits them and in cache which is too small, size is cache and glyph count */
+static void kernel_bench_font(void) {
+	static const font_cache_glyph_t glyph_counts[] = {FONT_CACHE_ITEMS / 2, FONT_CACHE_ITEMS * 4};
+	for (size_t i = 0; i < sizeof(glyph_counts) / sizeof(glyph_counts[0]); ++i) {
+		font_cache_t cache;
+		if (font_cache_init(&cache, FONT_CACHE_ITEMS, FONT_CACHE_ITEM) != ESP_OK) {
+			fprintf(stderr, "Font cache not initialized\n");
+			return;
+		}
+		kernel_data_t data = {
+			.cache = &cache,
+			.glyph = 0,
+			.glyph_count = glyph_counts[i],
+		};
+		kernel_case_t test = {"font", "", FONT_CACHE_ITEMS, glyph_counts[i], 0, "glyphs", 1};
+		snprintf(test.variant, sizeof(test.variant), "cache_%s", glyph_counts[i] <= FONT_CACHE_ITEMS ? "hit" : "miss");
+		kernel_measure(&test, kernel_font_cache, &data);
+		font_cache_destroy(&cache);
+	}
+
+#ifdef BENCH_FREETYPE
+	FILE *file = fopen(config.font, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Font %s not found, glyph rendering skipped\n", config.font);
+		return;
+	}
+	fseek(file, 0, SEEK_END);
+	const size_t size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	void *font_data = malloc(size);
+	const bool loaded = fread(font_data, 1, size, file) == size;
+	fclose(file);
+
+	font_face_t face;
+	if (!loaded || font_library_init_static(font_library_storage, sizeof(font_library_storage)) != ESP_OK || font_face_init_static(&face, font_data, size, font_face_storage, sizeof(font_face_storage)) != ESP_OK) {
+		fprintf(stderr, "Font %s not loaded\n", config.font);
+		font_library_destroy();
+		free(font_data);
+		return;
+	}
+	static const unsigned int pixel_sizes[] = {12, 16, 24};
+	for (size_t i = 0; i < sizeof(pixel_sizes) / sizeof(pixel_sizes[0]); ++i) {
+		font_render_t render;
+		if (font_render_init(&render, &face, pixel_sizes[i], FONT_CACHE_ITEMS) != ESP_OK) {
+			continue;
+		}
+		kernel_data_t data = {
+			.render = &render,
+			.code = 33,
+		};
+		kernel_case_t test = {"font", "place", pixel_sizes[i], pixel_sizes[i], 0, "glyphs", 1};
+		kernel_measure(&test, kernel_font_place, &data);
+		font_render_destroy(&render);
+	}
+	font_face_destroy(&face);
+	font_library_destroy();
+	free(font_data);
+#endif
+}
+
+
+static const char *kernel_arch(void) {
+#if defined(__x86_64__)
+	return "x86_64";
+#elif defined(__i386__)
+	return "x86";
+#elif defined(__aarch64__)
+	return "aarch64";
+#elif defined(__arm__)
+	return "arm";
+#elif defined(__riscv)
+	return "riscv";
+#elif defined(__XTENSA__)
+	return "xtensa";
+#else
+	return "unknown";
+#endif
+}
+
+
+static bool kernel_write_json(FILE *out) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"arch\": \"%s\",\n", kernel_arch());
+	fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+	fprintf(out, "  \"run_ms\": %.3f,\n", config.run_time / 1e6);
+	fprintf(out, "  \"repeat\": %u,\n", config.repeat);
+	fprintf(out, "  \"results\": [\n");
+	for (size_t i = 0; i < result_count; ++i) {
+		const kernel_result_t *result = &results[i];
+		fprintf(
+			out,
+			"    {\"kernel\": \"%s\", \"variant\": \"%s\", \"width\": %d, \"height\": %d, \"offset\": %d, \"unit\": \"%s\", \"units\": %zu, "
+			"\"iterations\": %zu, \"best_ns\": %.1f, \"median_ns\": %.1f, \"units_per_s\": %.0f}%s\n",
+			result->test.kernel,
+			result->test.variant,
+			result->test.width,
+			result->test.height,
+			result->test.offset,
+			result->test.unit,
+			result->test.units,
+			result->iterations,
+			result->best,
+			result->median,
+			result->test.units / result->best * 1e9,
+			i + 1 < result_count ? "," : ""
+		);
+	}
+	fprintf(out, "  ]\n}\n");
+	return !ferror(out);
+}
+
+
+static void kernel_usage(const char *program) {
+	printf(
+		"Usage: %s [options]\n"
+		"  --time MS          duration of every measured run (10)\n"
+		"  --repeat N         measured runs of every case, best and median are reported (5)\n"
+		"  --filter TEXT      run only cases whose kernel/variant contains TEXT\n"
+		"  --json FILE        write results as JSON, - writes only JSON to stdout\n"
+#ifdef BENCH_FREETYPE
+		"  --font FILE        TrueType font of glyph rendering (%s)\n"
+#endif
+		"\nKernels: fill, blit, convert, gray2, font\n"
+		"Offset is start of area in pixels from aligned address, for convert number of\n"
+		"pixels over multiple of 4.\n",
+		program
+#ifdef BENCH_FREETYPE
+		, BENCH_FONT
+#endif
+	);
+}
+
+
+int main(int argc, char *argv[]) {
+	config.run_time = 10 * 1000000LL;
+	config.repeat = 5;
+	config.filter = NULL;
+	config.json = NULL;
+#ifdef BENCH_FREETYPE
+	config.font = BENCH_FONT;
+#endif
+
+	enum {OPT_TIME = 256, OPT_REPEAT, OPT_FILTER, OPT_JSON, OPT_FONT, OPT_HELP};
+	static const struct option options[] = {
+		{"time", required_argument, NULL, OPT_TIME},
+		{"repeat", required_argument, NULL, OPT_REPEAT},
+		{"filter", required_argument, NULL, OPT_FILTER},
+		{"json", required_argument, NULL, OPT_JSON},
+#ifdef BENCH_FREETYPE
+		{"font", required_argument, NULL, OPT_FONT},
+#endif
+		{"help", no_argument, NULL, OPT_HELP},
+		{NULL, 0, NULL, 0}
+	};
+
+	int option;
+	while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+		switch (option) {
+			case OPT_TIME: config.run_time = (int64_t)(atof(optarg) * 1e6); break;
+			case OPT_REPEAT: config.repeat = strtoul(optarg, NULL, 10); break;
+			case OPT_FILTER: config.filter = optarg; break;
+			case OPT_JSON: config.json = optarg; break;
+			case OPT_FONT: config.font = optarg; break;
+			case OPT_HELP: kernel_usage(argv[0]); return 0;
+			default: kernel_usage(argv[0]); return 1;
+		}
+	}
+	if (config.repeat == 0 || config.repeat > REPEAT_MAX || config.run_time <= 0) {
+		fprintf(stderr, "Invalid run time or repeat count\n");
+		return 1;
+	}
+
+	const bool table = config.json == NULL || strcmp(config.json, "-") != 0;
+	if (table) {
+		printf("%-8s %-20s %9s %3s %10s %10s %10s\n", "kernel", "variant", "size", "off", "best_ns", "median_ns", "M/s");
+	}
+	kernel_bench_fill();
+	kernel_bench_blit();
+	kernel_bench_convert();
+	kernel_bench_gray2();
+	kernel_bench_font();
+
+	if (config.json != NULL) {
+		FILE *out = table ? fopen(config.json, "w") : stdout;
+		if (out == NULL) {
+			fprintf(stderr, "Can't write %s\n", config.json);
+			return 1;
+		}
+		const bool written = kernel_write_json(out);
+		if (out != stdout) {
+			fclose(out);
+		}
+		if (!written) {
+			fprintf(stderr, "Can't write %s\n", config.json);
+			return 1;
+		}
+	}
+	return 0;
+}
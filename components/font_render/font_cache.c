@@ -28,8 +28,35 @@ struct font_cache_priv {
 	void *data;
 	font_cache_access_t last_access;
 	font_cache_record_t *records;
+	// Statistics of font_cache_get
+	font_cache_stats_t stats;
+	// Memory is owned by caller
+	bool static_storage;
 };
 
+_Static_assert(sizeof(struct font_cache_priv) <= FONT_CACHE_PRIV_SIZE, "FONT_CACHE_PRIV_SIZE too small");
+_Static_assert(sizeof(font_cache_record_t) <= FONT_CACHE_RECORD_SIZE, "FONT_CACHE_RECORD_SIZE too small");
+
+
+static void font_cache_reset(font_cache_t *cache) {
+	cache->priv->last_access = 0;
+	cache->priv->stats.hits = 0;
+	cache->priv->stats.misses = 0;
+	for (size_t i = 0; i < cache->priv->size; ++i) {
+		cache->priv->records[i].glyph = UINT32_MAX;
+		cache->priv->records[i].index = i;
+		cache->priv->records[i].access_time = 0;
+	}
+}
+
+
+/* Take aligned part of caller storage */
+static void *font_storage_take(uint8_t **storage, size_t size) {
+	uint8_t *part = (uint8_t *)FONT_STORAGE_ROUND((uintptr_t)*storage);
+	*storage = part + FONT_STORAGE_ROUND(size);
+	return part;
+}
+
 
 esp_err_t font_cache_init(font_cache_t *cache, size_t cache_size, size_t item_size) {
 	assert(cache_size < UINT16_MAX);
@@ -41,9 +68,9 @@ esp_err_t font_cache_init(font_cache_t *cache, size_t cache_size, size_t item_si
 
 	cache->priv->records = NULL;
 	cache->priv->data = NULL;
-	cache->priv->last_access = 0;
 	cache->priv->size = cache_size;
 	cache->priv->item_size = item_size;
+	cache->priv->static_storage = false;
 
 	cache->priv->records = (font_cache_record_t *)heap_caps_malloc(sizeof(font_cache_record_t) * cache_size, FONT_CACHE_ALLOC);
 	if (cache->priv->records == NULL) {
@@ -57,11 +84,29 @@ esp_err_t font_cache_init(font_cache_t *cache, size_t cache_size, size_t item_si
 		return ESP_FAIL;
 	}
 
-	for (size_t i = 0; i < cache->priv->size; ++i) {
-		cache->priv->records[i].glyph = UINT32_MAX;
-		cache->priv->records[i].index = i;
+	font_cache_reset(cache);
+
+	return ESP_OK;
+}
+
+
+esp_err_t font_cache_init_static(font_cache_t *cache, size_t cache_size, size_t item_size, void *storage, size_t storage_size) {
+	assert(cache_size < UINT16_MAX);
+
+	if (storage_size < FONT_CACHE_STORAGE_SIZE(cache_size, item_size)) {
+		cache->priv = NULL;
+		return ESP_ERR_INVALID_SIZE;
 	}
 
+	uint8_t *data = (uint8_t *)storage;
+	cache->priv = (struct font_cache_priv *)font_storage_take(&data, sizeof(struct font_cache_priv));
+	cache->priv->records = (font_cache_record_t *)font_storage_take(&data, sizeof(font_cache_record_t) * cache_size);
+	cache->priv->data = font_storage_take(&data, item_size * cache_size);
+	cache->priv->size = cache_size;
+	cache->priv->item_size = item_size;
+	cache->priv->static_storage = true;
+	font_cache_reset(cache);
+
 	return ESP_OK;
 }
 
@@ -70,6 +115,10 @@ void font_cache_destroy(font_cache_t *cache) {
 	if (cache->priv == NULL) {
 		return;
 	}
+	if (cache->priv->static_storage) {
+		cache->priv = NULL;
+		return;
+	}
 	if (cache->priv->records != NULL) {
 		heap_caps_free(cache->priv->records);
 		cache->priv->records = NULL;
@@ -93,6 +142,7 @@ void *font_cache_get(font_cache_t *cache, font_cache_glyph_t glyph, bool *found)
 		font_cache_record_t *record = &cache->priv->records[i];
 		if (glyph == record->glyph) {
 			*found = true;
+			cache->priv->stats.hits++;
 			void *result = cache->priv->data + cache->priv->item_size * record->index;
 			record->access_time = cache->priv->last_access;
 			if (oldest_record != NULL) {
@@ -110,7 +160,13 @@ void *font_cache_get(font_cache_t *cache, font_cache_glyph_t glyph, bool *found)
 		}
 	}
 
+	cache->priv->stats.misses++;
 	oldest_record->glyph = glyph;
 	oldest_record->access_time = cache->priv->last_access;
 	return cache->priv->data + cache->priv->item_size * oldest_record->index;
 }
+
+
+void font_cache_get_stats(font_cache_t *cache, font_cache_stats_t *stats) {
+	*stats = cache->priv->stats;
+}
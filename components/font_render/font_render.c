@@ -1,5 +1,8 @@
 // SPDX-License-Identifier: MIT
 
+#include <string.h>
+#include <sys/param.h>
+
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 
@@ -8,6 +11,7 @@
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
 
 static FT_Library ft_library = NULL;
@@ -26,6 +30,8 @@ struct font_face_priv {
 	unsigned int pixel_size;
 	// Kerning support
 	bool has_kerning;
+	// Memory is owned by caller
+	bool static_storage;
 };
 
 
@@ -42,6 +48,8 @@ struct font_render_priv {
 	int line_height;
 	// Origin position from bottom in pixels
 	int origin_position;
+	// Memory is owned by caller
+	bool static_storage;
 
 	// Cache
 	font_cache_t glyph_metric_cache;
@@ -54,36 +62,217 @@ typedef struct font_glyph_metric {
 	font_delta_t advance;
 } font_glyph_metric_t;
 
+_Static_assert(sizeof(struct font_face_priv) <= FONT_FACE_PRIV_SIZE, "FONT_FACE_PRIV_SIZE too small");
+_Static_assert(sizeof(struct font_render_priv) <= FONT_RENDER_PRIV_SIZE, "FONT_RENDER_PRIV_SIZE too small");
+_Static_assert(sizeof(font_glyph_metric_t) <= FONT_GLYPH_METRIC_SIZE, "FONT_GLYPH_METRIC_SIZE too small");
 
-esp_err_t font_face_init(font_face_t *face, const void *data, size_t size) {
-	face->priv = (struct font_face_priv *)heap_caps_malloc(sizeof(struct font_face_priv), FONT_ALLOC);
-	if (face->priv == NULL) {
+
+/* Block of library pool, free blocks are linked in order of address */
+typedef struct font_pool_block {
+	// Size including header
+	size_t size;
+	// Overlaps data of used block
+	struct font_pool_block *next;
+} font_pool_block_t;
+
+#define FONT_POOL_HEADER FONT_STORAGE_ROUND(sizeof(size_t))
+#define FONT_POOL_BLOCK_MIN FONT_STORAGE_ROUND(sizeof(font_pool_block_t))
+
+typedef struct font_pool {
+	font_pool_block_t *free;
+	font_library_stats_t stats;
+} font_pool_t;
+
+// Memory of FreeType created by font_library_init_static
+static font_pool_t ft_pool;
+static struct FT_MemoryRec_ ft_pool_memory;
+
+
+static void *font_pool_alloc(FT_Memory memory, long size) {
+	font_pool_t *pool = (font_pool_t *)memory->user;
+	const size_t block_size = MAX(FONT_STORAGE_ROUND(FONT_POOL_HEADER + (size_t)size), FONT_POOL_BLOCK_MIN);
+
+	// First fit, rest of block stays free
+	font_pool_block_t **link = &pool->free;
+	while (*link != NULL && (*link)->size < block_size) {
+		link = &(*link)->next;
+	}
+	font_pool_block_t *block = *link;
+	if (block == NULL) {
+		pool->stats.failures++;
+		return NULL;
+	}
+	if (block->size - block_size >= FONT_POOL_BLOCK_MIN) {
+		font_pool_block_t *rest = (font_pool_block_t *)((uint8_t *)block + block_size);
+		rest->size = block->size - block_size;
+		rest->next = block->next;
+		block->size = block_size;
+		*link = rest;
+	}
+	else {
+		*link = block->next;
+	}
+
+	pool->stats.used += block->size;
+	pool->stats.high_water = MAX(pool->stats.high_water, pool->stats.used);
+	return (uint8_t *)block + FONT_POOL_HEADER;
+}
+
+
+static void font_pool_free(FT_Memory memory, void *data) {
+	font_pool_t *pool = (font_pool_t *)memory->user;
+	font_pool_block_t *block = (font_pool_block_t *)((uint8_t *)data - FONT_POOL_HEADER);
+	pool->stats.used -= block->size;
+
+	font_pool_block_t *previous = NULL;
+	font_pool_block_t *next = pool->free;
+	while (next != NULL && next < block) {
+		previous = next;
+		next = next->next;
+	}
+
+	// Neighbouring free blocks are merged
+	block->next = next;
+	if (next != NULL && (uint8_t *)block + block->size == (uint8_t *)next) {
+		block->size += next->size;
+		block->next = next->next;
+	}
+	if (previous == NULL) {
+		pool->free = block;
+	}
+	else if ((uint8_t *)previous + previous->size == (uint8_t *)block) {
+		previous->size += block->size;
+		previous->next = block->next;
+	}
+	else {
+		previous->next = block;
+	}
+}
+
+
+static void *font_pool_realloc(FT_Memory memory, long cur_size, long new_size, void *data) {
+	font_pool_block_t *block = (font_pool_block_t *)((uint8_t *)data - FONT_POOL_HEADER);
+	if (block->size >= FONT_POOL_HEADER + (size_t)new_size) {
+		return data;
+	}
+	void *result = font_pool_alloc(memory, new_size);
+	if (result == NULL) {
+		return NULL;
+	}
+	memcpy(result, data, MIN(cur_size, new_size));
+	font_pool_free(memory, data);
+	return result;
+}
+
+
+esp_err_t font_library_init_static(void *storage, size_t storage_size) {
+	if (ft_library != NULL) {
+		ESP_LOGE(TAG, "Freetype already loaded");
+		return ESP_ERR_INVALID_STATE;
+	}
+	if (storage_size < FONT_LIBRARY_STORAGE_SIZE(0) + FONT_POOL_BLOCK_MIN) {
+		ESP_LOGE(TAG, "Font library storage too small");
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	// Whole aligned storage is single free block
+	font_pool_block_t *block = (font_pool_block_t *)FONT_STORAGE_ROUND((uintptr_t)storage);
+	block->size = (storage_size - ((uint8_t *)block - (uint8_t *)storage)) & ~(size_t)(FONT_STORAGE_ALIGN - 1);
+	block->next = NULL;
+	ft_pool.free = block;
+	ft_pool.stats = (font_library_stats_t){0};
+
+	ft_pool_memory.user = &ft_pool;
+	ft_pool_memory.alloc = font_pool_alloc;
+	ft_pool_memory.free = font_pool_free;
+	ft_pool_memory.realloc = font_pool_realloc;
+
+	FT_Error err = FT_New_Library(&ft_pool_memory, &ft_library);
+	if (err) {
+		ESP_LOGE(TAG, "Freetype not loaded: %d", err);
+		ft_library = NULL;
 		return ESP_FAIL;
 	}
+	FT_Add_Default_Modules(ft_library);
+	return ESP_OK;
+}
+
+
+void font_library_destroy(void) {
+	if (ft_library == NULL) {
+		return;
+	}
+	// Memory of static library is not owned by FreeType
+	if (ft_pool_memory.user != NULL) {
+		FT_Done_Library(ft_library);
+		ft_pool_memory.user = NULL;
+		ft_pool.free = NULL;
+	}
+	else {
+		FT_Done_FreeType(ft_library);
+	}
+	ft_library = NULL;
+}
+
+
+void font_library_get_stats(font_library_stats_t *stats) {
+	*stats = ft_pool.stats;
+}
+
 
+static esp_err_t font_face_setup(struct font_face_priv *priv, const void *data, size_t size) {
 	FT_Error err;
-	face->priv->pixel_size = 0;
+	priv->pixel_size = 0;
 
 	if (ft_library == NULL) {
 		err = FT_Init_FreeType(&ft_library);
 		if (err) {
 			ESP_LOGE(TAG, "Freetype not loaded: %d", err);
-			heap_caps_free(face->priv);
-			face->priv = NULL;
 			return ESP_FAIL;
 		}
 	}
 
-	err = FT_New_Memory_Face(ft_library, data, size, 0, &face->priv->ft_face);
+	err = FT_New_Memory_Face(ft_library, data, size, 0, &priv->ft_face);
 	if (err) {
 		ESP_LOGE(TAG, "Call FT_New_Memory_Face failed: %d", err);
+		return ESP_FAIL;
+	}
+
+	priv->has_kerning = FT_HAS_KERNING(priv->ft_face);
+
+	return ESP_OK;
+}
+
+esp_err_t font_face_init(font_face_t *face, const void *data, size_t size) {
+	face->priv = (struct font_face_priv *)heap_caps_malloc(sizeof(struct font_face_priv), FONT_ALLOC);
+	if (face->priv == NULL) {
+		return ESP_FAIL;
+	}
+
+	if (font_face_setup(face->priv, data, size) != ESP_OK) {
 		heap_caps_free(face->priv);
 		face->priv = NULL;
 		return ESP_FAIL;
 	}
 
-	face->priv->has_kerning = FT_HAS_KERNING(face->priv->ft_face);
+	face->priv->static_storage = false;
+	return ESP_OK;
+}
+
+esp_err_t font_face_init_static(font_face_t *face, const void *data, size_t size, void *storage, size_t storage_size) {
+	face->priv = NULL;
+	if (storage_size < FONT_FACE_STORAGE_SIZE) {
+		ESP_LOGE(TAG, "Font face storage too small");
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	struct font_face_priv *priv = (struct font_face_priv *)FONT_STORAGE_ROUND((uintptr_t)storage);
+	if (font_face_setup(priv, data, size) != ESP_OK) {
+		return ESP_FAIL;
+	}
 
+	face->priv = priv;
+	face->priv->static_storage = true;
 	return ESP_OK;
 }
 
@@ -92,7 +281,9 @@ void font_face_destroy(font_face_t *face) {
 		return;
 	}
 	FT_Done_Face(face->priv->ft_face);
-	heap_caps_free(face->priv);
+	if (!face->priv->static_storage) {
+		heap_caps_free(face->priv);
+	}
 	face->priv = NULL;
 }
 
@@ -103,10 +294,22 @@ static esp_err_t font_face_set_pixel_size(font_face_t *face, unsigned int pixel_
 			ESP_LOGE(TAG, "Set font size failed: %d", err);
 			return ESP_FAIL;
 		}
+		face->priv->pixel_size = pixel_size;
 	}
 	return ESP_OK;
 }
 
+static void font_render_setup(font_render_t *render, font_face_t *face, unsigned int pixel_size) {
+	render->priv->font = face;
+	render->priv->pixel_size = pixel_size;
+	font_face_set_pixel_size(face, render->priv->pixel_size);
+
+	render->priv->max_glyph_width = FT_MulFix((face->priv->ft_face->bbox.xMax - face->priv->ft_face->bbox.xMin), face->priv->ft_face->size->metrics.x_scale) + ((1 << 6) - 1) >> 6;
+	render->priv->max_glyph_height = FT_MulFix((face->priv->ft_face->bbox.yMax - face->priv->ft_face->bbox.yMin), face->priv->ft_face->size->metrics.x_scale) + ((1 << 6) - 1) >> 6;
+	render->priv->line_height = (face->priv->ft_face->size->metrics.height) >> 6;
+	render->priv->origin_position = (-face->priv->ft_face->size->metrics.descender) >> 6;
+}
+
 esp_err_t font_render_init(font_render_t *render, font_face_t *face, unsigned int pixel_size, size_t cache_size) {
 	render->priv = (struct font_render_priv *)heap_caps_malloc(sizeof(struct font_render_priv), FONT_ALLOC);
 	if (render->priv == NULL) {
@@ -120,14 +323,31 @@ esp_err_t font_render_init(font_render_t *render, font_face_t *face, unsigned in
 		return ESP_FAIL;
 	}
 
-	render->priv->font = face;
-	render->priv->pixel_size = pixel_size;
-	font_face_set_pixel_size(face, render->priv->pixel_size);
+	render->priv->static_storage = false;
+	font_render_setup(render, face, pixel_size);
 
-	render->priv->max_glyph_width = FT_MulFix((face->priv->ft_face->bbox.xMax - face->priv->ft_face->bbox.xMin), face->priv->ft_face->size->metrics.x_scale) + ((1 << 6) - 1) >> 6;
-	render->priv->max_glyph_height = FT_MulFix((face->priv->ft_face->bbox.yMax - face->priv->ft_face->bbox.yMin), face->priv->ft_face->size->metrics.x_scale) + ((1 << 6) - 1) >> 6;
-	render->priv->line_height = (face->priv->ft_face->size->metrics.height) >> 6;
-	render->priv->origin_position = (-face->priv->ft_face->size->metrics.descender) >> 6;
+	return ESP_OK;
+}
+
+esp_err_t font_render_init_static(font_render_t *render, font_face_t *face, unsigned int pixel_size, size_t cache_size, void *storage, size_t storage_size) {
+	render->priv = NULL;
+	if (storage_size < FONT_RENDER_STORAGE_SIZE(cache_size)) {
+		ESP_LOGE(TAG, "Font render storage too small");
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	// Cache gets rest of storage
+	uint8_t *data = (uint8_t *)FONT_STORAGE_ROUND((uintptr_t)storage);
+	struct font_render_priv *priv = (struct font_render_priv *)data;
+	data += FONT_STORAGE_ROUND(sizeof(struct font_render_priv));
+	if (font_cache_init_static(&priv->glyph_metric_cache, cache_size, sizeof(font_glyph_metric_t), data, storage_size - (data - (uint8_t *)storage)) != ESP_OK) {
+		ESP_LOGE(TAG, "Font cache not initialized");
+		return ESP_FAIL;
+	}
+
+	render->priv = priv;
+	render->priv->static_storage = true;
+	font_render_setup(render, face, pixel_size);
 
 	return ESP_OK;
 }
@@ -137,7 +357,9 @@ void font_render_destroy(font_render_t *render) {
 		return;
 	}
 	font_cache_destroy(&render->priv->glyph_metric_cache);
-	heap_caps_free(render->priv);
+	if (!render->priv->static_storage) {
+		heap_caps_free(render->priv);
+	}
 	render->priv = NULL;
 }
 
@@ -145,6 +367,18 @@ int font_get_line_height(font_render_t *render) {
 	return render->priv->line_height;
 }
 
+/* Load glyph to slot of face, render sets size of shared face */
+static FT_GlyphSlot font_load_glyph(font_render_t *render, font_utf_code_t code) {
+	if (font_face_set_pixel_size(render->priv->font, render->priv->pixel_size) != ESP_OK) {
+		return NULL;
+	}
+	FT_Face face = render->priv->font->priv->ft_face;
+	if (FT_Load_Char(face, code, FT_LOAD_RENDER)) {
+		return NULL;
+	}
+	return face->glyph;
+}
+
 font_glyph_placement_t font_place_glyph(font_render_t *render, font_utf_code_t code, font_pos_t *pos, font_glyph_placement_t *previous) {
 	font_glyph_placement_t placement = {
 		.area = {0, 0, 0, 0},
@@ -152,26 +386,53 @@ font_glyph_placement_t font_place_glyph(font_render_t *render, font_utf_code_t c
 		.code.uint = code
 	};
 
-	FT_Face face = render->priv->font->priv->ft_face;
-	FT_Error err;
-	err = FT_Load_Char(face, code, FT_LOAD_RENDER);
-	if (err) {
-		return placement;
+	// Metrics of recently placed glyphs don't need FreeType
+	bool found;
+	font_glyph_metric_t *metric = (font_glyph_metric_t *)font_cache_get(&render->priv->glyph_metric_cache, code, &found);
+	if (!found) {
+		FT_GlyphSlot slot = font_load_glyph(render, code);
+		if (slot == NULL) {
+			// Missing glyph is cached as empty
+			*metric = (font_glyph_metric_t){{0, 0, 0, 0}, {0, 0}};
+		}
+		else {
+			metric->area.x = slot->bitmap_left;
+			metric->area.y = render->priv->line_height - slot->bitmap_top - render->priv->origin_position;
+			metric->area.width = slot->bitmap.width;
+			metric->area.height = slot->bitmap.rows;
+			metric->advance.x = slot->advance.x >> 6;
+			metric->advance.y = slot->advance.y >> 6;
+		}
 	}
 
-	FT_GlyphSlot slot = face->glyph;
-
-	font_glyph_metric_t metric_;
-	font_glyph_metric_t *metric = &metric_;
+	placement.area = metric->area;
+	placement.area.x += pos->x;
+	placement.area.y += pos->y;
+	placement.advance = metric->advance;
+	return placement;
+}
 
-	metric->area.x = slot->bitmap_left;
-	metric->area.y = render->priv->line_height - slot->bitmap_top - render->priv->origin_position;
-	metric->area.width = slot->bitmap.width;
-	metric->area.height = slot->bitmap.rows;
-	metric->advance.x = slot->advance.x >> 6;
-	metric->advance.y = slot->advance.y >> 6;
+esp_err_t font_render_glyph(font_render_t *render, font_glyph_placement_t *placement, uint8_t *bitmap, int stride) {
+	// Spaces have no bitmap
+	if (placement->area.width == 0 || placement->area.height == 0) {
+		return ESP_OK;
+	}
+	FT_GlyphSlot slot = font_load_glyph(render, placement->code.uint);
+	if (slot == NULL || slot->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+		return ESP_FAIL;
+	}
+	// Bitmap of caller is sized by placement
+	if ((int)slot->bitmap.width != placement->area.width || (int)slot->bitmap.rows != placement->area.height) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+	for (int y = 0; y < placement->area.height; ++y) {
+		memcpy(bitmap + y * stride, slot->bitmap.buffer + y * slot->bitmap.pitch, placement->area.width);
+	}
+	return ESP_OK;
+}
 
-	return placement;
+void font_render_get_cache_stats(font_render_t *render, font_cache_stats_t *stats) {
+	font_cache_get_stats(&render->priv->glyph_metric_cache, stats);
 }
 
 /*
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "esp_err.h"
@@ -10,6 +11,27 @@
 
 typedef uint32_t font_cache_glyph_t;
 
+/* Counters of lookups, counters wrap */
+typedef struct font_cache_stats {
+	uint32_t hits;
+	uint32_t misses;
+} font_cache_stats_t;
+
+
+/* Parts of caller provided storage are aligned to this size */
+#define FONT_STORAGE_ALIGN 8
+#define FONT_STORAGE_ROUND(size) (((size) + FONT_STORAGE_ALIGN - 1) & ~(size_t)(FONT_STORAGE_ALIGN - 1))
+
+/* Upper bounds of private structure sizes, checked at compile time */
+#define FONT_CACHE_PRIV_SIZE (6 * sizeof(size_t) + sizeof(font_cache_stats_t))
+#define FONT_CACHE_RECORD_SIZE (3 * sizeof(uint32_t))
+
+/* Bytes of storage for font_cache_init_static */
+#define FONT_CACHE_STORAGE_SIZE(cache_size, item_size) (FONT_STORAGE_ALIGN - 1 + \
+	FONT_STORAGE_ROUND(FONT_CACHE_PRIV_SIZE) + \
+	FONT_STORAGE_ROUND((cache_size) * FONT_CACHE_RECORD_SIZE) + \
+	FONT_STORAGE_ROUND((cache_size) * (item_size)))
+
 
 struct font_cache_priv;
 typedef struct font_cache {
@@ -18,5 +40,9 @@ typedef struct font_cache {
 
 
 esp_err_t font_cache_init(font_cache_t *cache, size_t cache_size, size_t item_size);
+/* Initialize cache in caller storage of FONT_CACHE_STORAGE_SIZE bytes, destroy doesn't free it */
+esp_err_t font_cache_init_static(font_cache_t *cache, size_t cache_size, size_t item_size, void *storage, size_t storage_size);
 void font_cache_destroy(font_cache_t *cache);
 void *font_cache_get(font_cache_t *cache, font_cache_glyph_t glyph, bool *found);
+/* Snapshot of lookup counters */
+void font_cache_get_stats(font_cache_t *cache, font_cache_stats_t *stats);
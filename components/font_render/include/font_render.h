@@ -6,6 +6,8 @@
 
 #include "esp_err.h"
 
+#include "font_cache.h"
+
 struct font_face_priv;
 struct font_render_priv;
 
@@ -35,6 +37,15 @@ typedef struct font_pos {
 	int y;
 } font_pos_t;
 
+/* Memory of FreeType library pool in bytes */
+typedef struct font_library_stats {
+	size_t used;
+	/* Maximum of used bytes since init, pool of this size never fails */
+	size_t high_water;
+	/* Number of failed allocations */
+	size_t failures;
+} font_library_stats_t;
+
 typedef struct font_glyph_placement {
 	/* Area required for glyph */
 	font_area_t area;
@@ -47,14 +58,52 @@ typedef struct font_glyph_placement {
 } font_glyph_placement_t;
 
 
+/* Upper bounds of private structure sizes, checked at compile time */
+#define FONT_FACE_PRIV_SIZE (sizeof(void *) + 2 * sizeof(int))
+#define FONT_RENDER_PRIV_SIZE (2 * sizeof(void *) + 6 * sizeof(int))
+#define FONT_GLYPH_METRIC_SIZE (6 * sizeof(int))
+
+/* Bytes of storage for font_face_init_static */
+#define FONT_FACE_STORAGE_SIZE (FONT_STORAGE_ALIGN - 1 + FONT_STORAGE_ROUND(FONT_FACE_PRIV_SIZE))
+
+/* Bytes of storage for font_render_init_static */
+#define FONT_RENDER_STORAGE_SIZE(cache_size) (FONT_STORAGE_ALIGN - 1 + \
+	FONT_STORAGE_ROUND(FONT_RENDER_PRIV_SIZE) + \
+	FONT_CACHE_STORAGE_SIZE(cache_size, FONT_GLYPH_METRIC_SIZE))
+
+
+/* Bytes of storage for font_library_init_static with pool_size bytes for FreeType */
+#define FONT_LIBRARY_STORAGE_SIZE(pool_size) (FONT_STORAGE_ALIGN - 1 + FONT_STORAGE_ROUND(pool_size))
+
+
+/* Serve all FreeType allocations from caller storage, must be called before first font_face_init
+ *
+ * Without it FreeType uses heap. Faces allocate their tables when loaded and every rendered
+ * glyph reallocates bitmap of glyph slot, pool keeps these allocations off heap.
+ */
+esp_err_t font_library_init_static(void *storage, size_t storage_size);
+/* Release FreeType library after all faces were destroyed */
+void font_library_destroy(void);
+/* Usage of pool of font_library_init_static */
+void font_library_get_stats(font_library_stats_t *stats);
+
 esp_err_t font_face_init(font_face_t *face, const void *data, size_t size);
+/* Initialize face in caller storage of FONT_FACE_STORAGE_SIZE bytes, destroy doesn't free it */
+esp_err_t font_face_init_static(font_face_t *face, const void *data, size_t size, void *storage, size_t storage_size);
 void font_face_destroy(font_face_t *face);
 
 esp_err_t font_render_init(font_render_t *render, font_face_t *face, unsigned int pixel_size, size_t cache_size);
+/* Initialize render in caller storage of FONT_RENDER_STORAGE_SIZE bytes, destroy doesn't free it */
+esp_err_t font_render_init_static(font_render_t *render, font_face_t *face, unsigned int pixel_size, size_t cache_size, void *storage, size_t storage_size);
 void font_render_destroy(font_render_t *render);
 
 int font_get_line_height(font_render_t *render);
+/* Area of glyph drawn at pos and advance to next glyph, metrics are cached */
 font_glyph_placement_t font_place_glyph(font_render_t *render, font_utf_code_t code, font_pos_t *pos, font_glyph_placement_t *previous);
+/* Render glyph of placement as 8 bit coverage to bitmap of area size with stride bytes per row */
+esp_err_t font_render_glyph(font_render_t *render, font_glyph_placement_t *placement, uint8_t *bitmap, int stride);
+/* Lookups of glyph metric cache by font_place_glyph */
+void font_render_get_cache_stats(font_render_t *render, font_cache_stats_t *stats);
 
 
 /*
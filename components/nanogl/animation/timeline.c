@@ -0,0 +1,175 @@
+#include "nanogl.h"
+#include "nanogl/animation.h"
+
+
+int32_t ngl_ease(ngl_easing_t easing, int32_t progress) {
+	const int64_t t = progress;
+	const int64_t one = NGL_ANIMATION_ONE;
+	switch (easing) {
+		case NGL_EASING_IN_QUAD:
+			return (t * t) >> 16;
+		case NGL_EASING_OUT_QUAD:
+			return (t * (2 * one - t)) >> 16;
+		case NGL_EASING_IN_OUT_QUAD:
+			if (t < one / 2) {
+				return (2 * t * t) >> 16;
+			}
+			return one - ((2 * (one - t) * (one - t)) >> 16);
+		case NGL_EASING_IN_OUT_CUBIC:
+			if (t < one / 2) {
+				return (4 * ((t * t) >> 16) * t) >> 16;
+			}
+			return one - ((4 * (((one - t) * (one - t)) >> 16) * (one - t)) >> 16);
+		case NGL_EASING_LINEAR:
+		default:
+			return progress;
+	}
+}
+
+
+static inline int ngl_animation_lerp(int from, int to, int32_t progress) {
+	return from + (int)(((int64_t)(to - from) * progress) >> 16);
+}
+
+
+void ngl_animation_area_init(ngl_animation_t *animation, ngl_widget_t *widget, ngl_area_t *to, int64_t duration, ngl_easing_t easing) {
+	animation->widget = widget;
+	animation->property = NGL_ANIMATION_AREA;
+	animation->easing = easing;
+	animation->duration = duration;
+	animation->area.from = widget->area;
+	animation->area.to = *to;
+	animation->done = NULL;
+	animation->user_data = NULL;
+	animation->running = false;
+	animation->next = NULL;
+}
+
+
+void ngl_animation_color_init(ngl_animation_t *animation, ngl_widget_t *widget, ngl_color_t *color, ngl_color_t to, int64_t duration, ngl_easing_t easing) {
+	animation->widget = widget;
+	animation->property = NGL_ANIMATION_COLOR;
+	animation->easing = easing;
+	animation->duration = duration;
+	animation->color.target = color;
+	animation->color.from = *color;
+	animation->color.to = to;
+	animation->done = NULL;
+	animation->user_data = NULL;
+	animation->running = false;
+	animation->next = NULL;
+}
+
+
+/* Set widget area, only union of previous and new bounds is redrawn */
+static void ngl_animation_set_area(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t *area) {
+	if (widget->area.x == area->x && widget->area.y == area->y && widget->area.width == area->width && widget->area.height == area->height) {
+		return;
+	}
+	ngl_area_t dirty = widget->bounds;
+	widget->area = *area;
+	ngl_widget_update_bounds(widget);
+	ngl_send_event(driver, widget, NGL_EVENT_RESHAPE, &widget->area);
+	ngl_area_union(&dirty, &widget->bounds, &dirty);
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &dirty);
+}
+
+
+static void ngl_animation_apply(ngl_driver_t *driver, ngl_animation_t *animation, int32_t progress) {
+	progress = ngl_ease(animation->easing, progress);
+	switch (animation->property) {
+		case NGL_ANIMATION_AREA: {
+			ngl_area_t *from = &animation->area.from;
+			ngl_area_t *to = &animation->area.to;
+			ngl_area_t area = {
+				ngl_animation_lerp(from->x, to->x, progress),
+				ngl_animation_lerp(from->y, to->y, progress),
+				ngl_animation_lerp(from->width, to->width, progress),
+				ngl_animation_lerp(from->height, to->height, progress),
+			};
+			ngl_animation_set_area(driver, animation->widget, &area);
+			break;
+		}
+		case NGL_ANIMATION_COLOR: {
+			ngl_rgba_t *from = &animation->color.from.rgba;
+			ngl_rgba_t *to = &animation->color.to.rgba;
+			ngl_color_t color;
+			color.rgba.r = ngl_animation_lerp(from->r, to->r, progress);
+			color.rgba.g = ngl_animation_lerp(from->g, to->g, progress);
+			color.rgba.b = ngl_animation_lerp(from->b, to->b, progress);
+			color.rgba.a = ngl_animation_lerp(from->a, to->a, progress);
+			if (color.value != animation->color.target->value) {
+				*animation->color.target = color;
+				ngl_widget_invalidate(driver, animation->widget);
+			}
+			break;
+		}
+	}
+}
+
+
+void ngl_animation_start(ngl_driver_t *driver, ngl_animation_t *animation) {
+	if (animation->running) {
+		ngl_animation_stop(driver, animation);
+	}
+	switch (animation->property) {
+		case NGL_ANIMATION_AREA:
+			animation->area.from = animation->widget->area;
+			break;
+		case NGL_ANIMATION_COLOR:
+			animation->color.from = *animation->color.target;
+			break;
+	}
+	animation->start = ngl_time(driver);
+	animation->running = true;
+	animation->next = driver->animations;
+	driver->animations = animation;
+	ngl_request_frame(driver, 0);
+}
+
+
+void ngl_animation_stop(ngl_driver_t *driver, ngl_animation_t *animation) {
+	ngl_animation_t **link = &driver->animations;
+	while (*link != NULL) {
+		if (*link == animation) {
+			*link = animation->next;
+			break;
+		}
+		link = &(*link)->next;
+	}
+	animation->running = false;
+	animation->next = NULL;
+}
+
+
+void ngl_animations_update(ngl_driver_t *driver) {
+	if (driver->animations == NULL) {
+		return;
+	}
+
+	// Progress depends only on wall clock, slow frames skip steps
+	const int64_t now = ngl_time(driver);
+	ngl_animation_t **link = &driver->animations;
+	while (*link != NULL) {
+		ngl_animation_t *animation = *link;
+		const int64_t elapsed = now - animation->start;
+		if (elapsed < animation->duration) {
+			ngl_animation_apply(driver, animation, elapsed <= 0 ? 0 : (int32_t)((elapsed << 16) / animation->duration));
+			link = &animation->next;
+		}
+		else {
+			ngl_animation_apply(driver, animation, NGL_ANIMATION_ONE);
+			*link = animation->next;
+			animation->running = false;
+			animation->next = NULL;
+			if (animation->done != NULL) {
+				animation->done(driver, animation);
+			}
+		}
+	}
+
+	if (driver->animations != NULL) {
+		ngl_request_frame(driver, 0);
+	}
+}
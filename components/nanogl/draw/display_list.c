@@ -0,0 +1,66 @@
+#include "nanogl.h"
+
+
+void ngl_display_list_init(ngl_display_list_t *list, ngl_command_t *commands, size_t capacity) {
+	list->commands = commands;
+	list->capacity = capacity;
+	list->count = 0;
+	list->overflow = false;
+}
+
+
+static ngl_command_t *ngl_display_list_add(ngl_display_list_t *list, ngl_command_type_t type, ngl_area_t *bounds, ngl_color_t color) {
+	if (list->count == list->capacity) {
+		list->overflow = true;
+		return NULL;
+	}
+	ngl_command_t *command = &list->commands[list->count++];
+	command->type = type;
+	command->bounds = *bounds;
+	command->color = color;
+	command->source = NULL;
+	return command;
+}
+
+
+static void ngl_display_list_record_fill(ngl_buffer_t *target, ngl_area_t *area, ngl_color_t color) {
+	ngl_area_t bounds;
+	if (!ngl_area_intersection(&target->clip, area, &bounds)) {
+		return;
+	}
+	ngl_display_list_add(target->recorder, NGL_COMMAND_FILL, &bounds, color);
+}
+
+
+static void ngl_display_list_record_pixmap(ngl_buffer_t *target, ngl_buffer_t *source, ngl_area_t *crop, ngl_color_t color) {
+	ngl_area_t bounds;
+	if (!ngl_area_intersection(&target->clip, &source->area, &bounds)) {
+		return;
+	}
+	if (crop != NULL && !ngl_area_intersection(&bounds, crop, &bounds)) {
+		return;
+	}
+	ngl_command_t *command = ngl_display_list_add(target->recorder, NGL_COMMAND_PIXMAP, &bounds, color);
+	if (command != NULL) {
+		command->source = source;
+	}
+}
+
+
+/* Draw commands intersecting target */
+static void ngl_display_list_replay(ngl_display_list_t *list, ngl_buffer_t *target) {
+	for (size_t i = 0; i < list->count; ++i) {
+		ngl_command_t *command = &list->commands[i];
+		if (!ngl_area_intersects(&command->bounds, &target->clip)) {
+			continue;
+		}
+		switch (command->type) {
+			case NGL_COMMAND_FILL:
+				ngl_fill_area(target, &command->bounds, command->color);
+				break;
+			case NGL_COMMAND_PIXMAP:
+				ngl_draw_pixmap(target, command->source, &command->bounds, command->color);
+				break;
+		}
+	}
+}
@@ -0,0 +1,322 @@
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "nanogl.h"
+#include "pixel.h"
+
+
+/* Repeated pixel bytes, long enough to start at any phase of 3 words */
+typedef struct ngl_fill_pattern {
+	ngl_byte_t bytes[32];
+	size_t pixel_size;
+} ngl_fill_pattern_t;
+
+
+static void ngl_fill_pattern_init(ngl_fill_pattern_t *pattern, const ngl_byte_t *pixel, size_t pixel_size) {
+	pattern->pixel_size = pixel_size;
+	for (size_t i = 0; i < sizeof(pattern->bytes); ++i) {
+		pattern->bytes[i] = pixel[i % pixel_size];
+	}
+}
+
+
+static NGL_ALWAYS_INLINE uint64_t ngl_fill_pattern_word(ngl_fill_pattern_t *pattern, size_t offset) {
+	uint64_t word;
+	memcpy(&word, pattern->bytes + (offset % pattern->pixel_size), sizeof(word));
+	return word;
+}
+
+
+/* Fill bytes with repeated pixel, size must be multiple of pixel size */
+static void ngl_fill_bytes(ngl_byte_t *target, size_t size, ngl_fill_pattern_t *pattern) {
+	// Align to 8 bytes
+	size_t head = (-(uintptr_t)target) & 0x07;
+	if (head > size) {
+		head = size;
+	}
+	memcpy(target, pattern->bytes, head);
+	target += head;
+	size -= head;
+
+	if (pattern->pixel_size == 3) {
+		// Period of 3 bytes repeats every 3 words
+		const uint64_t word0 = ngl_fill_pattern_word(pattern, head);
+		const uint64_t word1 = ngl_fill_pattern_word(pattern, head + 8);
+		const uint64_t word2 = ngl_fill_pattern_word(pattern, head + 16);
+		while (size >= 24) {
+			memcpy(target, &word0, 8);
+			memcpy(target + 8, &word1, 8);
+			memcpy(target + 16, &word2, 8);
+			target += 24;
+			size -= 24;
+		}
+	}
+	else {
+		const uint64_t word = ngl_fill_pattern_word(pattern, head);
+#if defined(__SSE2__)
+		const __m128i wide = _mm_set1_epi64x(word);
+		if (size >= 8 && ((uintptr_t)target & 0x0f)) {
+			memcpy(target, &word, 8);
+			target += 8;
+			size -= 8;
+		}
+		while (size >= 32) {
+			_mm_store_si128((__m128i *)target, wide);
+			_mm_store_si128((__m128i *)(target + 16), wide);
+			target += 32;
+			size -= 32;
+		}
+#elif defined(__ARM_NEON)
+		const uint64x2_t wide = vdupq_n_u64(word);
+		while (size >= 32) {
+			vst1q_u64((uint64_t *)target, wide);
+			vst1q_u64((uint64_t *)(target + 16), wide);
+			target += 32;
+			size -= 32;
+		}
+#else
+		while (size >= 32) {
+			memcpy(target, &word, 8);
+			memcpy(target + 8, &word, 8);
+			memcpy(target + 16, &word, 8);
+			memcpy(target + 24, &word, 8);
+			target += 32;
+			size -= 32;
+		}
+#endif
+		while (size >= 8) {
+			memcpy(target, &word, 8);
+			target += 8;
+			size -= 8;
+		}
+	}
+
+	memcpy(target, pattern->bytes + (head % pattern->pixel_size), size);
+}
+
+
+/* Blend bytes with repeated pixel, alpha in range 0 - 256
+ *
+ * Works on 32 bit words, even and odd bytes are blended by one
+ * multiplication each. Every byte is handled as independent channel so the
+ * same code blends gray, RGB and RGBA pixels.
+ */
+static void ngl_blend_bytes(ngl_byte_t *target, size_t size, ngl_fill_pattern_t *pattern, uint32_t alpha) {
+	const uint32_t inverse = 256 - alpha;
+
+	size_t head = (-(uintptr_t)target) & 0x03;
+	if (head > size) {
+		head = size;
+	}
+	for (size_t i = 0; i < head; ++i) {
+		target[i] = (pattern->bytes[i] * alpha + target[i] * inverse) >> 8;
+	}
+	target += head;
+	size -= head;
+
+	// Period of 3 bytes repeats every 3 words
+	const size_t period = pattern->pixel_size == 3 ? 3 : 1;
+	uint32_t source_even[3];
+	uint32_t source_odd[3];
+	for (size_t i = 0; i < period; ++i) {
+		uint32_t word;
+		memcpy(&word, pattern->bytes + ((head + i * 4) % pattern->pixel_size), sizeof(word));
+		source_even[i] = (word & 0x00ff00ff) * alpha;
+		source_odd[i] = ((word >> 8) & 0x00ff00ff) * alpha;
+	}
+
+	size_t word_num = 0;
+	while (size >= 4) {
+		uint32_t word;
+		memcpy(&word, target, sizeof(word));
+		const uint32_t even = ((source_even[word_num] + (word & 0x00ff00ff) * inverse) >> 8) & 0x00ff00ff;
+		const uint32_t odd = (source_odd[word_num] + ((word >> 8) & 0x00ff00ff) * inverse) & 0xff00ff00;
+		word = even | odd;
+		memcpy(target, &word, sizeof(word));
+		target += 4;
+		size -= 4;
+		word_num++;
+		if (word_num == period) {
+			word_num = 0;
+		}
+	}
+
+	const ngl_byte_t *source = pattern->bytes + ((head + word_num * 4) % pattern->pixel_size);
+	for (size_t i = 0; i < size; ++i) {
+		target[i] = (source[i] * alpha + target[i] * inverse) >> 8;
+	}
+}
+
+
+/* Blend single RGB565 pixel, channels are spread to 32 bit word and blended by single multiplication */
+static NGL_ALWAYS_INLINE uint32_t ngl_blend_rgb565_pixel(uint32_t pixel, uint32_t source, uint32_t inverse5) {
+	pixel = (pixel | (pixel << 16)) & 0x07e0f81f;
+	pixel = ((source + pixel * inverse5) >> 5) & 0x07e0f81f;
+	return (pixel | (pixel >> 16)) & 0xffff;
+}
+
+
+/* Blend RGB565 pixels, aligned pairs are loaded and stored as single 32 bit word */
+static void ngl_blend_rgb565(uint16_t *target, size_t count, ngl_color_t color, uint32_t alpha) {
+	const uint32_t alpha5 = alpha >> 3;
+	const uint32_t inverse5 = 32 - alpha5;
+	uint32_t source = ngl_color_to_rgb565(color);
+	source = ((source | (source << 16)) & 0x07e0f81f) * alpha5;
+
+	// Align to 4 bytes
+	if (count > 0 && ((uintptr_t)target & 0x02)) {
+		*target = ngl_blend_rgb565_pixel(*target, source, inverse5);
+		target++;
+		count--;
+	}
+
+	// Spread pixel needs all 31 bits of product, pair is split to two words sharing load and store
+	for (; count >= 2; count -= 2, target += 2) {
+		uint32_t pair;
+		memcpy(&pair, target, sizeof(pair));
+		pair = ngl_blend_rgb565_pixel(pair & 0xffff, source, inverse5) | (ngl_blend_rgb565_pixel(pair >> 16, source, inverse5) << 16);
+		memcpy(target, &pair, sizeof(pair));
+	}
+
+	if (count > 0) {
+		*target = ngl_blend_rgb565_pixel(*target, source, inverse5);
+	}
+}
+
+
+/* Fill bit range of packed format, pattern contains whole byte of repeated pixel */
+static void ngl_fill_bits(ngl_byte_t *target, size_t first_bit, size_t bits, ngl_byte_t pattern) {
+	target += first_bit >> 3;
+	const unsigned int offset = first_bit & 0x07;
+
+	// Masked first byte
+	if (offset) {
+		const unsigned int head_bits = MIN(8 - offset, bits);
+		const ngl_byte_t mask = ((1 << head_bits) - 1) << offset;
+		*target = (*target & ~mask) | (pattern & mask);
+		target++;
+		bits -= head_bits;
+	}
+
+	const size_t size = bits >> 3;
+	memset(target, pattern, size);
+	target += size;
+
+	// Masked last byte
+	bits &= 0x07;
+	if (bits) {
+		const ngl_byte_t mask = (1 << bits) - 1;
+		*target = (*target & ~mask) | (pattern & mask);
+	}
+}
+
+
+/* Blend with translucent color */
+static void ngl_fill_area_blend(ngl_buffer_t *target, size_t first_pixel, size_t line_pixels, int lines, ngl_color_t color) {
+	const size_t stride = target->stride;
+	const uint32_t alpha = ngl_alpha_expand(color.rgba.a);
+	color.rgba.a = 255;
+
+	switch (target->format) {
+		case NGL_MONO:
+			// Single bit can't be blended, only more than half visible color is drawn
+			if (alpha >= 128) {
+				for (int line = 0; line < lines; ++line) {
+					ngl_fill_bits(target->buffer, first_pixel + line * stride, line_pixels, ngl_color_luminance(color) >= 128 ? 0xff : 0x00);
+				}
+			}
+			break;
+		case NGL_GRAY_2:
+			for (int line = 0; line < lines; ++line) {
+				size_t pos = first_pixel + line * stride;
+				for (size_t i = 0; i < line_pixels; ++i, ++pos) {
+					ngl_pixel_store(NGL_GRAY_2, target->buffer, pos, ngl_color_blend(ngl_pixel_load(NGL_GRAY_2, target->buffer, pos), color, alpha));
+				}
+			}
+			break;
+		case NGL_RGB_565:
+			for (int line = 0; line < lines; ++line) {
+				ngl_blend_rgb565((uint16_t *)target->buffer + first_pixel + line * stride, line_pixels, color, alpha);
+			}
+			break;
+		default: {
+			const size_t pixel_size = ngl_get_color_bits(target->format) >> 3;
+			ngl_byte_t pixel[4] = {0};
+			ngl_pixel_store(target->format, pixel, 0, color);
+			ngl_fill_pattern_t pattern;
+			ngl_fill_pattern_init(&pattern, pixel, pixel_size);
+			for (int line = 0; line < lines; ++line) {
+				ngl_blend_bytes(target->buffer + (first_pixel + line * stride) * pixel_size, line_pixels * pixel_size, &pattern, alpha);
+			}
+			break;
+		}
+	}
+}
+
+
+void ngl_fill_area(ngl_buffer_t *target, ngl_area_t *area, ngl_color_t color) {
+	// Fully transparent
+	if (color.rgba.a == 0) {
+		return;
+	}
+
+	if (target->recorder != NULL) {
+		ngl_display_list_record_fill(target, area, color);
+		return;
+	}
+
+	ngl_area_t visible_area;
+	if (!ngl_area_intersection(&target->clip, area, &visible_area)) {
+		return;
+	}
+
+	const size_t stride = target->stride;
+	size_t first_pixel = (visible_area.x - target->area.x) + (visible_area.y - target->area.y) * stride;
+	size_t line_pixels = visible_area.width;
+	int lines = visible_area.height;
+
+	// Full width fill of buffer without gaps between lines is single continuous block
+	if ((size_t)visible_area.width == stride) {
+		line_pixels *= lines;
+		lines = 1;
+	}
+
+	if (color.rgba.a != 255) {
+		ngl_fill_area_blend(target, first_pixel, line_pixels, lines, color);
+		return;
+	}
+
+	switch (target->format) {
+		case NGL_MONO:
+		case NGL_GRAY_2: {
+			const size_t bits = ngl_get_color_bits(target->format);
+			ngl_byte_t pattern;
+			if (target->format == NGL_MONO) {
+				pattern = ngl_color_luminance(color) >= 128 ? 0xff : 0x00;
+			}
+			else {
+				pattern = (ngl_color_luminance(color) >> 6) * 0x55;
+			}
+			for (int line = 0; line < lines; ++line) {
+				ngl_fill_bits(target->buffer, (first_pixel + line * stride) * bits, line_pixels * bits, pattern);
+			}
+			break;
+		}
+		default: {
+			const size_t pixel_size = ngl_get_color_bits(target->format) >> 3;
+			ngl_byte_t pixel[4] = {0};
+			ngl_pixel_store(target->format, pixel, 0, color);
+			ngl_fill_pattern_t pattern;
+			ngl_fill_pattern_init(&pattern, pixel, pixel_size);
+			for (int line = 0; line < lines; ++line) {
+				ngl_fill_bytes(target->buffer + (first_pixel + line * stride) * pixel_size, line_pixels * pixel_size, &pattern);
+			}
+			break;
+		}
+	}
+}
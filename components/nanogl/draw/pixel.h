@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+#define NGL_ALWAYS_INLINE inline __attribute__((always_inline))
+
+
+/*
+ * Pixel layout of color formats
+ *
+ * NGL_MONO and NGL_GRAY_2 are packed from least significant bits, pixel
+ * index continues across lines. NGL_RGB_565 is stored as native uint16_t,
+ * NGL_RGB_888 as r, g, b bytes and NGL_RGBA as ngl_color_t.
+ */
+
+
+/* Formats used as alpha mask by pixmap drawing */
+static NGL_ALWAYS_INLINE bool ngl_format_is_mask(const ngl_color_format_t format) {
+	return format == NGL_MONO || format == NGL_GRAY_2 || format == NGL_GRAY_8;
+}
+
+
+static NGL_ALWAYS_INLINE uint32_t ngl_color_luminance(ngl_color_t color) {
+	return ((uint32_t)color.rgba.r * 77 + (uint32_t)color.rgba.g * 150 + (uint32_t)color.rgba.b * 29) >> 8;
+}
+
+
+/* Convert 8 bit alpha to range 0 - 256 */
+static NGL_ALWAYS_INLINE uint32_t ngl_alpha_expand(uint32_t alpha) {
+	return alpha + (alpha >> 7);
+}
+
+
+/* Mix colors, alpha is in range 0 - 256, two channels are computed by single multiplication */
+static NGL_ALWAYS_INLINE ngl_color_t ngl_color_blend(ngl_color_t target, ngl_color_t source, uint32_t alpha) {
+	const uint32_t inverse = 256 - alpha;
+	const uint32_t rb = ((source.value & 0x00ff00ff) * alpha + (target.value & 0x00ff00ff) * inverse) >> 8;
+	const uint32_t ga = ((source.value >> 8) & 0x00ff00ff) * alpha + ((target.value >> 8) & 0x00ff00ff) * inverse;
+	ngl_color_t result;
+	result.value = (rb & 0x00ff00ff) | (ga & 0xff00ff00);
+	return result;
+}
+
+
+/* Multiply all channels */
+static NGL_ALWAYS_INLINE ngl_color_t ngl_color_tint(ngl_color_t color, ngl_color_t tint) {
+	color.rgba.r = ((uint32_t)color.rgba.r * ngl_alpha_expand(tint.rgba.r)) >> 8;
+	color.rgba.g = ((uint32_t)color.rgba.g * ngl_alpha_expand(tint.rgba.g)) >> 8;
+	color.rgba.b = ((uint32_t)color.rgba.b * ngl_alpha_expand(tint.rgba.b)) >> 8;
+	color.rgba.a = ((uint32_t)color.rgba.a * ngl_alpha_expand(tint.rgba.a)) >> 8;
+	return color;
+}
+
+
+static NGL_ALWAYS_INLINE uint16_t ngl_color_to_rgb565(ngl_color_t color) {
+	return ((uint16_t)(color.rgba.r >> 3) << 11) | ((uint16_t)(color.rgba.g >> 2) << 5) | (uint16_t)(color.rgba.b >> 3);
+}
+
+
+static NGL_ALWAYS_INLINE ngl_color_t ngl_color_from_rgb565(uint16_t value) {
+	ngl_color_t color;
+	const uint8_t r = value >> 11;
+	const uint8_t g = (value >> 5) & 0x3f;
+	const uint8_t b = value & 0x1f;
+	color.rgba.r = (r << 3) | (r >> 2);
+	color.rgba.g = (g << 2) | (g >> 4);
+	color.rgba.b = (b << 3) | (b >> 2);
+	color.rgba.a = 255;
+	return color;
+}
+
+
+static NGL_ALWAYS_INLINE ngl_color_t ngl_color_from_gray(uint8_t value) {
+	ngl_color_t color;
+	color.rgba.r = value;
+	color.rgba.g = value;
+	color.rgba.b = value;
+	color.rgba.a = 255;
+	return color;
+}
+
+
+/* Read mask value of pixel in range 0 - 255 */
+static NGL_ALWAYS_INLINE uint32_t ngl_pixel_mask(const ngl_color_format_t format, const ngl_byte_t *buffer, size_t index) {
+	switch (format) {
+		case NGL_MONO:
+			return ((buffer[index >> 3] >> (index & 0x07)) & 0x01) * 255;
+		case NGL_GRAY_2:
+			return ((buffer[index >> 2] >> ((index & 0x03) << 1)) & 0x03) * 85;
+		case NGL_GRAY_8:
+			return buffer[index];
+		default:
+			return 0;
+	}
+}
+
+
+static NGL_ALWAYS_INLINE ngl_color_t ngl_pixel_load(const ngl_color_format_t format, const ngl_byte_t *buffer, size_t index) {
+	switch (format) {
+		case NGL_MONO:
+		case NGL_GRAY_2:
+		case NGL_GRAY_8:
+			return ngl_color_from_gray(ngl_pixel_mask(format, buffer, index));
+		case NGL_RGB_565:
+			return ngl_color_from_rgb565(((const uint16_t *)buffer)[index]);
+		case NGL_RGB_888: {
+			ngl_color_t color;
+			color.rgba.r = buffer[index * 3];
+			color.rgba.g = buffer[index * 3 + 1];
+			color.rgba.b = buffer[index * 3 + 2];
+			color.rgba.a = 255;
+			return color;
+		}
+		case NGL_RGBA:
+		default:
+			return ((const ngl_color_t *)buffer)[index];
+	}
+}
+
+
+static NGL_ALWAYS_INLINE void ngl_pixel_store(const ngl_color_format_t format, ngl_byte_t *buffer, size_t index, ngl_color_t color) {
+	switch (format) {
+		case NGL_MONO: {
+			const ngl_byte_t bit = 1 << (index & 0x07);
+			if (ngl_color_luminance(color) >= 128) {
+				buffer[index >> 3] |= bit;
+			}
+			else {
+				buffer[index >> 3] &= ~bit;
+			}
+			break;
+		}
+		case NGL_GRAY_2: {
+			const unsigned int shift = (index & 0x03) << 1;
+			ngl_byte_t *byte = &buffer[index >> 2];
+			*byte = (*byte & ~(0x03 << shift)) | ((ngl_color_luminance(color) >> 6) << shift);
+			break;
+		}
+		case NGL_GRAY_8:
+			buffer[index] = ngl_color_luminance(color);
+			break;
+		case NGL_RGB_565:
+			((uint16_t *)buffer)[index] = ngl_color_to_rgb565(color);
+			break;
+		case NGL_RGB_888:
+			buffer[index * 3] = color.rgba.r;
+			buffer[index * 3 + 1] = color.rgba.g;
+			buffer[index * 3 + 2] = color.rgba.b;
+			break;
+		case NGL_RGBA:
+			((ngl_color_t *)buffer)[index] = color;
+			break;
+	}
+}
@@ -0,0 +1,162 @@
+#include <string.h>
+
+#include "nanogl.h"
+#include "pixel.h"
+
+
+typedef struct ngl_blit {
+	const ngl_byte_t *source;
+	ngl_byte_t *target;
+	// Pixel index of first visible pixel
+	size_t source_index;
+	size_t target_index;
+	// Line length in pixels
+	size_t source_stride;
+	size_t target_stride;
+	int width;
+	int height;
+	ngl_color_t color;
+} ngl_blit_t;
+
+typedef void (*ngl_blit_fn)(ngl_blit_t *blit);
+
+
+/* Inner loop, formats are constant in every instance so all format switches are resolved at compile time */
+static NGL_ALWAYS_INLINE void ngl_blit_generic(ngl_blit_t *blit, const ngl_color_format_t source_format, const ngl_color_format_t target_format) {
+	const ngl_color_t color = blit->color;
+	const uint32_t color_alpha = ngl_alpha_expand(color.rgba.a);
+	const bool tint = color.value != 0xffffffff;
+	const unsigned short source_bits = ngl_get_color_bits(source_format);
+	ngl_color_t solid = color;
+	solid.rgba.a = 255;
+
+	// Same opaque format without tint is plain copy
+	if (source_format == target_format && !tint && (source_format == NGL_RGB_565 || source_format == NGL_RGB_888)) {
+		const size_t pixel_size = source_bits >> 3;
+		for (int y = 0; y < blit->height; ++y) {
+			memcpy(
+				blit->target + (blit->target_index + y * blit->target_stride) * pixel_size,
+				blit->source + (blit->source_index + y * blit->source_stride) * pixel_size,
+				blit->width * pixel_size
+			);
+		}
+		return;
+	}
+
+	for (int y = 0; y < blit->height; ++y) {
+		size_t source_pos = blit->source_index + y * blit->source_stride;
+		size_t target_pos = blit->target_index + y * blit->target_stride;
+		int x = 0;
+		while (x < blit->width) {
+			if (ngl_format_is_mask(source_format)) {
+				// Skip whole empty bytes of packed masks
+				if (source_bits < 8) {
+					const unsigned int pixels_per_byte = 8 / source_bits;
+					if ((source_pos % pixels_per_byte) == 0 && blit->source[source_pos / pixels_per_byte] == 0 && x + pixels_per_byte <= blit->width) {
+						x += pixels_per_byte;
+						source_pos += pixels_per_byte;
+						target_pos += pixels_per_byte;
+						continue;
+					}
+				}
+
+				const uint32_t mask = ngl_pixel_mask(source_format, blit->source, source_pos);
+				if (mask != 0) {
+					const uint32_t alpha = (ngl_alpha_expand(mask) * color_alpha) >> 8;
+					if (alpha == 256) {
+						ngl_pixel_store(target_format, blit->target, target_pos, solid);
+					}
+					else {
+						ngl_pixel_store(target_format, blit->target, target_pos, ngl_color_blend(ngl_pixel_load(target_format, blit->target, target_pos), solid, alpha));
+					}
+				}
+			}
+			else {
+				ngl_color_t pixel = ngl_pixel_load(source_format, blit->source, source_pos);
+				if (tint) {
+					pixel = ngl_color_tint(pixel, color);
+				}
+				const uint32_t alpha = ngl_alpha_expand(pixel.rgba.a);
+				if (alpha == 256) {
+					ngl_pixel_store(target_format, blit->target, target_pos, pixel);
+				}
+				else if (alpha != 0) {
+					pixel.rgba.a = 255;
+					ngl_pixel_store(target_format, blit->target, target_pos, ngl_color_blend(ngl_pixel_load(target_format, blit->target, target_pos), pixel, alpha));
+				}
+			}
+			x++;
+			source_pos++;
+			target_pos++;
+		}
+	}
+}
+
+
+#define NGL_BLIT_DEFINE(source, target, source_format, target_format) \
+	static void ngl_blit_##source##_##target(ngl_blit_t *blit) { \
+		ngl_blit_generic(blit, source_format, target_format); \
+	}
+
+#define NGL_BLIT_DEFINE_SOURCE(source, source_format) \
+	NGL_BLIT_DEFINE(source, mono, source_format, NGL_MONO) \
+	NGL_BLIT_DEFINE(source, gray_2, source_format, NGL_GRAY_2) \
+	NGL_BLIT_DEFINE(source, gray_8, source_format, NGL_GRAY_8) \
+	NGL_BLIT_DEFINE(source, rgb_565, source_format, NGL_RGB_565) \
+	NGL_BLIT_DEFINE(source, rgb_888, source_format, NGL_RGB_888) \
+	NGL_BLIT_DEFINE(source, rgba, source_format, NGL_RGBA)
+
+#define NGL_BLIT_TABLE_ROW(source) { \
+		ngl_blit_##source##_mono, \
+		ngl_blit_##source##_gray_2, \
+		ngl_blit_##source##_gray_8, \
+		ngl_blit_##source##_rgb_565, \
+		ngl_blit_##source##_rgb_888, \
+		ngl_blit_##source##_rgba, \
+	}
+
+NGL_BLIT_DEFINE_SOURCE(mono, NGL_MONO)
+NGL_BLIT_DEFINE_SOURCE(gray_2, NGL_GRAY_2)
+NGL_BLIT_DEFINE_SOURCE(gray_8, NGL_GRAY_8)
+NGL_BLIT_DEFINE_SOURCE(rgb_565, NGL_RGB_565)
+NGL_BLIT_DEFINE_SOURCE(rgb_888, NGL_RGB_888)
+NGL_BLIT_DEFINE_SOURCE(rgba, NGL_RGBA)
+
+/* Indexed by [source format][target format] */
+static const ngl_blit_fn ngl_blit_table[6][6] = {
+	NGL_BLIT_TABLE_ROW(mono),
+	NGL_BLIT_TABLE_ROW(gray_2),
+	NGL_BLIT_TABLE_ROW(gray_8),
+	NGL_BLIT_TABLE_ROW(rgb_565),
+	NGL_BLIT_TABLE_ROW(rgb_888),
+	NGL_BLIT_TABLE_ROW(rgba),
+};
+
+
+void ngl_draw_pixmap(ngl_buffer_t *target, ngl_buffer_t *source, ngl_area_t *crop, ngl_color_t color) {
+	if (target->recorder != NULL) {
+		ngl_display_list_record_pixmap(target, source, crop, color);
+		return;
+	}
+
+	ngl_area_t visible_area;
+	if (!ngl_area_intersection(&target->clip, &source->area, &visible_area)) {
+		return;
+	}
+	if (crop != NULL && !ngl_area_intersection(&visible_area, crop, &visible_area)) {
+		return;
+	}
+
+	ngl_blit_t blit = {
+		.source = source->buffer,
+		.target = target->buffer,
+		.source_index = (visible_area.x - source->area.x) + (visible_area.y - source->area.y) * source->stride,
+		.target_index = (visible_area.x - target->area.x) + (visible_area.y - target->area.y) * target->stride,
+		.source_stride = source->stride,
+		.target_stride = target->stride,
+		.width = visible_area.width,
+		.height = visible_area.height,
+		.color = color,
+	};
+	ngl_blit_table[source->format][target->format](&blit);
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanogl/driver_memory.h"
+
+
+typedef struct ngl_memory_driver_priv {
+	// Whole screen
+	ngl_buffer_t screen;
+	// View of current band
+	ngl_buffer_t band;
+	int band_lines;
+	bool owns_framebuffer;
+	ngl_memory_driver_stats_t stats;
+} ngl_memory_driver_priv_t;
+
+
+static ngl_buffer_t *ngl_memory_driver_get_window(ngl_driver_t *driver, ngl_area_t *area) {
+	ngl_memory_driver_priv_t *priv = (ngl_memory_driver_priv_t *)driver->priv;
+	ngl_area_t band_area = *area;
+	if (band_area.height > priv->band_lines) {
+		band_area.height = priv->band_lines;
+	}
+	ngl_buffer_view(&priv->screen, &band_area, &priv->band);
+	return &priv->band;
+}
+
+
+static ngl_buffer_t *ngl_memory_driver_get_buffer(ngl_driver_t *driver) {
+	ngl_memory_driver_priv_t *priv = (ngl_memory_driver_priv_t *)driver->priv;
+	ngl_area_t area = {0, 0, driver->width, driver->height};
+	if (priv->band.area.y + priv->band.area.height < driver->height) {
+		area.y = priv->band.area.y + priv->band.area.height;
+		area.height -= area.y;
+	}
+	return ngl_memory_driver_get_window(driver, &area);
+}
+
+
+static void ngl_memory_driver_flush(ngl_driver_t *driver) {
+	ngl_memory_driver_priv_t *priv = (ngl_memory_driver_priv_t *)driver->priv;
+	priv->stats.bands++;
+	priv->stats.pixels += (uint64_t)priv->band.area.width * priv->band.area.height;
+}
+
+
+bool ngl_memory_driver_init(ngl_driver_t *driver, ngl_memory_driver_init_struct_t *config) {
+	ngl_memory_driver_priv_t *priv = (ngl_memory_driver_priv_t *)malloc(sizeof(ngl_memory_driver_priv_t));
+	if (priv == NULL) {
+		return false;
+	}
+
+	const unsigned short bits = ngl_get_color_bits(config->format);
+	ngl_byte_t *framebuffer = config->framebuffer;
+	priv->owns_framebuffer = framebuffer == NULL;
+	if (framebuffer == NULL) {
+		framebuffer = (ngl_byte_t *)calloc(((size_t)config->width * config->height * bits + 7) >> 3, 1);
+		if (framebuffer == NULL) {
+			free(priv);
+			return false;
+		}
+	}
+
+	driver->priv = priv;
+	driver->width = config->width;
+	driver->height = config->height;
+	driver->format = config->format;
+	driver->get_buffer = ngl_memory_driver_get_buffer;
+	driver->flush = ngl_memory_driver_flush;
+	driver->end_frame = NULL;
+	driver->get_stats = NULL;
+	// Windows of packed formats would not start at byte boundary
+	driver->get_window = config->windows && bits >= 8 ? ngl_memory_driver_get_window : NULL;
+	ngl_driver_init(driver);
+
+	ngl_area_t screen = {0, 0, config->width, config->height};
+	ngl_buffer_init(&priv->screen, &screen, framebuffer, config->format, driver);
+	ngl_area_t band = {0, 0, config->width, 0};
+	ngl_buffer_init(&priv->band, &band, framebuffer, config->format, driver);
+
+	// Bands of packed formats start at byte boundary
+	int band_lines = config->band_lines > 0 && config->band_lines < config->height ? config->band_lines : config->height;
+	while (((size_t)band_lines * config->width * bits) & 0x07) {
+		band_lines++;
+	}
+	priv->band_lines = band_lines;
+	memset(&priv->stats, 0, sizeof(priv->stats));
+	return true;
+}
+
+
+void ngl_memory_driver_destroy(ngl_driver_t *driver) {
+	ngl_memory_driver_priv_t *priv = (ngl_memory_driver_priv_t *)driver->priv;
+	if (priv == NULL) {
+		return;
+	}
+	if (priv->owns_framebuffer) {
+		free(priv->screen.buffer);
+	}
+	free(priv);
+	driver->priv = NULL;
+	ngl_driver_destroy(driver);
+}
+
+
+ngl_buffer_t *ngl_memory_driver_framebuffer(ngl_driver_t *driver) {
+	return &((ngl_memory_driver_priv_t *)driver->priv)->screen;
+}
+
+
+ngl_memory_driver_stats_t *ngl_memory_driver_stats(ngl_driver_t *driver) {
+	return &((ngl_memory_driver_priv_t *)driver->priv)->stats;
+}
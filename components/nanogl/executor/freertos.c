@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "nanogl/executor_freertos.h"
+
+
+typedef struct ngl_freertos_executor_priv {
+	TaskHandle_t *tasks;
+	size_t task_count;
+	// Given by every helper after finishing its part of jobs
+	SemaphoreHandle_t done;
+	bool stop;
+	// Memory is owned by caller
+	bool static_storage;
+
+	ngl_job_fn job;
+	void *arg;
+	size_t count;
+	size_t next;
+} ngl_freertos_executor_priv_t;
+
+_Static_assert(sizeof(ngl_freertos_executor_priv_t) <= NGL_FREERTOS_EXECUTOR_PRIV_SIZE, "NGL_FREERTOS_EXECUTOR_PRIV_SIZE too small");
+
+
+static void ngl_freertos_executor_run_jobs(ngl_freertos_executor_priv_t *priv) {
+	size_t index;
+	while ((index = __atomic_fetch_add(&priv->next, 1, __ATOMIC_RELAXED)) < priv->count) {
+		priv->job(priv->arg, index);
+	}
+}
+
+
+static void ngl_freertos_executor_task(void *arg) {
+	ngl_freertos_executor_priv_t *priv = (ngl_freertos_executor_priv_t *)arg;
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (priv->stop) {
+			break;
+		}
+		ngl_freertos_executor_run_jobs(priv);
+		xSemaphoreGive(priv->done);
+	}
+	xSemaphoreGive(priv->done);
+	vTaskDelete(NULL);
+}
+
+
+static void ngl_freertos_executor_run(ngl_executor_t *executor, ngl_job_fn job, void *arg, size_t count) {
+	ngl_freertos_executor_priv_t *priv = (ngl_freertos_executor_priv_t *)executor->priv;
+	if (count == 0) {
+		return;
+	}
+
+	priv->job = job;
+	priv->arg = arg;
+	priv->count = count;
+	priv->next = 0;
+
+	// Wake only helpers which can get any job
+	size_t helpers = MIN(priv->task_count, count - 1);
+	for (size_t i = 0; i < helpers; ++i) {
+		xTaskNotifyGive(priv->tasks[i]);
+	}
+	ngl_freertos_executor_run_jobs(priv);
+	for (size_t i = 0; i < helpers; ++i) {
+		xSemaphoreTake(priv->done, portMAX_DELAY);
+	}
+}
+
+
+static void ngl_freertos_executor_stop(ngl_freertos_executor_priv_t *priv) {
+	priv->stop = true;
+	for (size_t i = 0; i < priv->task_count; ++i) {
+		xTaskNotifyGive(priv->tasks[i]);
+	}
+	for (size_t i = 0; i < priv->task_count; ++i) {
+		xSemaphoreTake(priv->done, portMAX_DELAY);
+	}
+	priv->task_count = 0;
+}
+
+
+/* Take aligned part of caller storage or allocate it if there is no storage */
+static void *ngl_freertos_executor_alloc(uint8_t **storage, size_t size) {
+	if (*storage == NULL) {
+		return malloc(size);
+	}
+	uint8_t *part = (uint8_t *)NGL_STORAGE_ROUND((uintptr_t)*storage);
+	*storage = part + NGL_STORAGE_ROUND(size);
+	return part;
+}
+
+
+static bool ngl_freertos_executor_create_task(ngl_freertos_executor_priv_t *priv, size_t index, UBaseType_t priority, uint8_t **storage) {
+	if (priv->static_storage) {
+		StaticTask_t *task_buffer = (StaticTask_t *)ngl_freertos_executor_alloc(storage, sizeof(StaticTask_t));
+		StackType_t *stack = (StackType_t *)ngl_freertos_executor_alloc(storage, NGL_FREERTOS_EXECUTOR_STACK_SIZE * sizeof(StackType_t));
+#if portNUM_PROCESSORS > 1
+		priv->tasks[index] = xTaskCreateStaticPinnedToCore(&ngl_freertos_executor_task, "ngl_worker", NGL_FREERTOS_EXECUTOR_STACK_SIZE, priv, priority, stack, task_buffer, (index + 1) % portNUM_PROCESSORS);
+#else
+		priv->tasks[index] = xTaskCreateStatic(&ngl_freertos_executor_task, "ngl_worker", NGL_FREERTOS_EXECUTOR_STACK_SIZE, priv, priority, stack, task_buffer);
+#endif
+		return priv->tasks[index] != NULL;
+	}
+#if portNUM_PROCESSORS > 1
+	return xTaskCreatePinnedToCore(&ngl_freertos_executor_task, "ngl_worker", NGL_FREERTOS_EXECUTOR_STACK_SIZE, priv, priority, &priv->tasks[index], (index + 1) % portNUM_PROCESSORS) == pdPASS;
+#else
+	return xTaskCreate(&ngl_freertos_executor_task, "ngl_worker", NGL_FREERTOS_EXECUTOR_STACK_SIZE, priv, priority, &priv->tasks[index]) == pdPASS;
+#endif
+}
+
+
+static bool ngl_freertos_executor_init_storage(ngl_executor_t *executor, size_t workers, uint8_t *storage) {
+	executor->run = ngl_freertos_executor_run;
+	executor->workers = 1;
+	executor->priv = NULL;
+	if (workers == 0) {
+		workers = 1;
+	}
+
+	ngl_freertos_executor_priv_t *priv = (ngl_freertos_executor_priv_t *)ngl_freertos_executor_alloc(&storage, sizeof(ngl_freertos_executor_priv_t));
+	if (priv == NULL) {
+		return false;
+	}
+	priv->tasks = NULL;
+	priv->task_count = 0;
+	priv->stop = false;
+	priv->static_storage = storage != NULL;
+	priv->count = 0;
+	priv->next = 0;
+	executor->priv = priv;
+
+	if (priv->static_storage) {
+		StaticSemaphore_t *done_buffer = (StaticSemaphore_t *)ngl_freertos_executor_alloc(&storage, sizeof(StaticSemaphore_t));
+		priv->done = xSemaphoreCreateCountingStatic(workers, 0, done_buffer);
+	}
+	else {
+		priv->done = xSemaphoreCreateCounting(workers, 0);
+	}
+	if (workers > 1) {
+		priv->tasks = (TaskHandle_t *)ngl_freertos_executor_alloc(&storage, sizeof(TaskHandle_t) * (workers - 1));
+	}
+	if (priv->done == NULL || (workers > 1 && priv->tasks == NULL)) {
+		ngl_freertos_executor_destroy(executor);
+		return false;
+	}
+
+	const UBaseType_t priority = uxTaskPriorityGet(NULL);
+	for (size_t i = 0; i < workers - 1; ++i) {
+		if (!ngl_freertos_executor_create_task(priv, i, priority, &storage)) {
+			ngl_freertos_executor_destroy(executor);
+			return false;
+		}
+		priv->task_count++;
+	}
+
+	executor->workers = workers;
+	return true;
+}
+
+
+bool ngl_freertos_executor_init(ngl_executor_t *executor, size_t workers) {
+	return ngl_freertos_executor_init_storage(executor, workers, NULL);
+}
+
+
+bool ngl_freertos_executor_init_static(ngl_executor_t *executor, size_t workers, void *storage, size_t storage_size) {
+	if (storage == NULL || storage_size < NGL_FREERTOS_EXECUTOR_STORAGE_SIZE(workers)) {
+		executor->run = ngl_freertos_executor_run;
+		executor->workers = 1;
+		executor->priv = NULL;
+		return false;
+	}
+	return ngl_freertos_executor_init_storage(executor, workers, (uint8_t *)storage);
+}
+
+
+void ngl_freertos_executor_destroy(ngl_executor_t *executor) {
+	ngl_freertos_executor_priv_t *priv = (ngl_freertos_executor_priv_t *)executor->priv;
+	if (priv != NULL) {
+		ngl_freertos_executor_stop(priv);
+		if (priv->done != NULL) {
+			vSemaphoreDelete(priv->done);
+		}
+		if (!priv->static_storage) {
+			free(priv->tasks);
+			free(priv);
+		}
+		executor->priv = NULL;
+	}
+	executor->workers = 1;
+}
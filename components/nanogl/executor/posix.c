@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include "nanogl/executor_posix.h"
+
+
+typedef struct ngl_posix_executor_priv {
+	pthread_t *threads;
+	size_t thread_count;
+	pthread_mutex_t mutex;
+	pthread_cond_t start;
+	pthread_cond_t finished;
+	// Incremented for every batch of jobs
+	unsigned long generation;
+	size_t running;
+	bool stop;
+
+	ngl_job_fn job;
+	void *arg;
+	size_t count;
+	size_t next;
+} ngl_posix_executor_priv_t;
+
+
+static void ngl_posix_executor_run_jobs(ngl_posix_executor_priv_t *priv) {
+	size_t index;
+	while ((index = __atomic_fetch_add(&priv->next, 1, __ATOMIC_RELAXED)) < priv->count) {
+		priv->job(priv->arg, index);
+	}
+}
+
+
+static void *ngl_posix_executor_thread(void *arg) {
+	ngl_posix_executor_priv_t *priv = (ngl_posix_executor_priv_t *)arg;
+
+	// Signals belong to threads of application (simulated scheduler uses them)
+	sigset_t signals;
+	sigfillset(&signals);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	unsigned long generation = 0;
+	pthread_mutex_lock(&priv->mutex);
+	while (1) {
+		while (!priv->stop && priv->generation == generation) {
+			pthread_cond_wait(&priv->start, &priv->mutex);
+		}
+		if (priv->stop) {
+			break;
+		}
+		generation = priv->generation;
+		pthread_mutex_unlock(&priv->mutex);
+
+		ngl_posix_executor_run_jobs(priv);
+
+		pthread_mutex_lock(&priv->mutex);
+		priv->running--;
+		if (priv->running == 0) {
+			pthread_cond_signal(&priv->finished);
+		}
+	}
+	pthread_mutex_unlock(&priv->mutex);
+	return NULL;
+}
+
+
+static void ngl_posix_executor_run(ngl_executor_t *executor, ngl_job_fn job, void *arg, size_t count) {
+	ngl_posix_executor_priv_t *priv = (ngl_posix_executor_priv_t *)executor->priv;
+
+	pthread_mutex_lock(&priv->mutex);
+	priv->job = job;
+	priv->arg = arg;
+	priv->count = count;
+	priv->next = 0;
+	priv->running = priv->thread_count;
+	priv->generation++;
+	pthread_cond_broadcast(&priv->start);
+	pthread_mutex_unlock(&priv->mutex);
+
+	ngl_posix_executor_run_jobs(priv);
+
+	pthread_mutex_lock(&priv->mutex);
+	while (priv->running > 0) {
+		pthread_cond_wait(&priv->finished, &priv->mutex);
+	}
+	pthread_mutex_unlock(&priv->mutex);
+}
+
+
+bool ngl_posix_executor_init(ngl_executor_t *executor, size_t workers) {
+	executor->run = ngl_posix_executor_run;
+	executor->workers = 1;
+	executor->priv = NULL;
+	if (workers == 0) {
+		workers = 1;
+	}
+
+	ngl_posix_executor_priv_t *priv = (ngl_posix_executor_priv_t *)malloc(sizeof(ngl_posix_executor_priv_t));
+	if (priv == NULL) {
+		return false;
+	}
+	priv->threads = NULL;
+	priv->thread_count = 0;
+	priv->generation = 0;
+	priv->running = 0;
+	priv->stop = false;
+	priv->count = 0;
+	priv->next = 0;
+	pthread_mutex_init(&priv->mutex, NULL);
+	pthread_cond_init(&priv->start, NULL);
+	pthread_cond_init(&priv->finished, NULL);
+	executor->priv = priv;
+
+	if (workers > 1) {
+		priv->threads = (pthread_t *)malloc(sizeof(pthread_t) * (workers - 1));
+		if (priv->threads == NULL) {
+			ngl_posix_executor_destroy(executor);
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < workers - 1; ++i) {
+		if (pthread_create(&priv->threads[i], NULL, ngl_posix_executor_thread, priv) != 0) {
+			ngl_posix_executor_destroy(executor);
+			return false;
+		}
+		priv->thread_count++;
+	}
+
+	executor->workers = workers;
+	return true;
+}
+
+
+void ngl_posix_executor_destroy(ngl_executor_t *executor) {
+	ngl_posix_executor_priv_t *priv = (ngl_posix_executor_priv_t *)executor->priv;
+	if (priv != NULL) {
+		pthread_mutex_lock(&priv->mutex);
+		priv->stop = true;
+		pthread_cond_broadcast(&priv->start);
+		pthread_mutex_unlock(&priv->mutex);
+		for (size_t i = 0; i < priv->thread_count; ++i) {
+			pthread_join(priv->threads[i], NULL);
+		}
+		pthread_cond_destroy(&priv->finished);
+		pthread_cond_destroy(&priv->start);
+		pthread_mutex_destroy(&priv->mutex);
+		free(priv->threads);
+		free(priv);
+		executor->priv = NULL;
+	}
+	executor->workers = 1;
+}
@@ -2,9 +2,38 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+
+/* Maximum number of separate dirty rectangles tracked by driver */
+#ifndef NGL_DIRTY_AREAS_MAX
+#define NGL_DIRTY_AREAS_MAX 8
+#endif
+
+/* Maximum nesting of ngl_push_clip */
+#ifndef NGL_CLIP_STACK_MAX
+#define NGL_CLIP_STACK_MAX 8
+#endif
+
+/* Parts of caller provided storage are aligned to this size */
+#define NGL_STORAGE_ALIGN 8
+/* Size of storage part rounded to alignment */
+#define NGL_STORAGE_ROUND(size) (((size) + NGL_STORAGE_ALIGN - 1) & ~(size_t)(NGL_STORAGE_ALIGN - 1))
+
+/* Bytes of storage for ngl_driver_set_sweep_storage with capacity top level widgets */
+#define NGL_SWEEP_STORAGE_SIZE(capacity) (NGL_STORAGE_ALIGN - 1 + \
+	2 * NGL_STORAGE_ROUND((capacity) * sizeof(size_t)) + \
+	2 * NGL_STORAGE_ROUND((capacity) * sizeof(ngl_area_t)))
+
+/* Widget covers whole own area with opaque pixels, widgets below are not drawn */
+#define NGL_WIDGET_OPAQUE 0x01
+/* Children of widget are clipped to its area */
+#define NGL_WIDGET_CLIP_CHILDREN 0x02
+/* Widget draws its children from cached surface, see nanogl/cache.h */
+#define NGL_WIDGET_CACHED 0x04
+
 typedef enum ngl_color_format {
 	NGL_MONO,
 	NGL_GRAY_2,
@@ -24,13 +53,29 @@ typedef enum ngl_event {
 	NGL_EVENT_USER = 1000,
 } ngl_event_t;
 
+struct ngl_animation;
+struct ngl_area;
+struct ngl_display_list;
 struct ngl_driver;
 struct ngl_buffer;
+struct ngl_executor;
+struct ngl_frame_arena;
+struct ngl_profiler;
+struct ngl_scheduler;
+struct ngl_stats;
 struct ngl_widget;
 
 typedef struct ngl_buffer *(*ngl_driver_get_buffer_fn) (struct ngl_driver *driver);
+typedef struct ngl_buffer *(*ngl_driver_get_window_fn) (struct ngl_driver *driver, struct ngl_area *area);
 typedef void (*ngl_driver_flush_fn) (struct ngl_driver *driver);
+typedef void (*ngl_driver_end_frame_fn) (struct ngl_driver *driver);
+typedef void (*ngl_driver_get_stats_fn) (struct ngl_driver *driver, struct ngl_stats *stats);
 typedef void (*ngl_widget_process_event_fn) (struct ngl_driver *driver, struct ngl_widget *widget, ngl_event_t event, void *data);
+typedef void (*ngl_job_fn) (void *arg, size_t index);
+typedef void (*ngl_executor_run_fn) (struct ngl_executor *executor, ngl_job_fn job, void *arg, size_t count);
+typedef bool (*ngl_scheduler_wait_fn) (struct ngl_scheduler *scheduler, int64_t timeout_us);
+typedef void (*ngl_scheduler_wake_fn) (struct ngl_scheduler *scheduler);
+typedef int64_t (*ngl_scheduler_now_fn) (struct ngl_scheduler *scheduler);
 typedef unsigned char ngl_byte_t;
 
 typedef struct ngl_area {
@@ -43,10 +88,66 @@ typedef struct ngl_area {
 typedef struct ngl_buffer {
 	ngl_area_t area;
 	ngl_byte_t *buffer;
+	/* Line length of pixel data in pixels, equal to area width unless buffer is view into larger surface */
+	size_t stride;
 	ngl_color_format_t format;
 	struct ngl_driver *driver;
+	/* Drawing functions record commands to display list instead of drawing if set */
+	struct ngl_display_list *recorder;
+	/* Intersection of area and all pushed clip areas, empty if nothing is visible */
+	ngl_area_t clip;
+	ngl_area_t clip_stack[NGL_CLIP_STACK_MAX];
+	size_t clip_depth;
 } ngl_buffer_t;
 
+typedef struct ngl_dirty_region {
+	ngl_area_t areas[NGL_DIRTY_AREAS_MAX];
+	size_t count;
+} ngl_dirty_region_t;
+
+/* Widgets ordered by top edge and widgets crossing current band */
+typedef struct ngl_sweep {
+	size_t *order;
+	size_t *active;
+	/* Visible part of active widgets */
+	ngl_area_t *clips;
+	/* Opaque areas above currently processed widget */
+	ngl_area_t *occluders;
+	size_t capacity;
+	size_t count;
+	size_t next;
+	size_t active_count;
+	/* Arrays are in caller storage, never reallocated */
+	bool static_storage;
+} ngl_sweep_t;
+
+/* Counters of drawing, kept in release builds
+ *
+ * Counters wrap, readers should use differences of two snapshots.
+ */
+typedef struct ngl_stats {
+	/* Frames drawn by ngl_draw_frame */
+	uint32_t frames;
+	/* Frames without any changed area */
+	uint32_t frames_skipped;
+	/* Bands rendered and flushed */
+	uint32_t bands;
+	/* Screen lines not redrawn because nothing changed in them */
+	uint32_t lines_skipped;
+	/* Cached widgets per frame drawn from valid surface, and widgets whose surface was redrawn or didn't fit */
+	uint32_t cache_hits;
+	uint32_t cache_misses;
+	/* Counted by display driver, zero if driver does not count them */
+	uint32_t pixels_converted;
+	uint32_t bus_bytes;
+	/* Time spent waiting for free transfer buffer in microseconds */
+	uint32_t queue_wait_us;
+	/* Not counters, copied from driver arena to size it, zero without arena */
+	size_t arena_size;
+	size_t arena_high_water;
+	size_t arena_failures;
+} ngl_stats_t;
+
 typedef struct ngl_driver {
 	int width;
 	int height;
@@ -55,13 +156,76 @@ typedef struct ngl_driver {
 
 	ngl_driver_get_buffer_fn get_buffer;
 	ngl_driver_flush_fn flush;
+	/* Optional, returns buffer starting at area->y covering at most area */
+	ngl_driver_get_window_fn get_window;
+	/* Optional, called after last buffer of frame was flushed */
+	ngl_driver_end_frame_fn end_frame;
+	/* Optional, adds counters of display driver to stats */
+	ngl_driver_get_stats_fn get_stats;
+
+	/* Areas changed since last frame */
+	ngl_dirty_region_t dirty;
+	/* Band culling state of ngl_draw_frame */
+	ngl_sweep_t sweep;
+	/* Optional, widgets are drawn once per frame to display list replayed for every band */
+	struct ngl_display_list *display_list;
+	/* Optional, replayed bands are split to tiles rendered concurrently */
+	struct ngl_executor *executor;
+	/* Optional, used by ngl_wait_frame and as clock of animations */
+	struct ngl_scheduler *scheduler;
+	/* Running animations, updated at start of every frame */
+	struct ngl_animation *animations;
+	/* Optional, memory of ngl_frame_alloc, released after NGL_EVENT_FRAME_END */
+	struct ngl_frame_arena *arena;
+	/* Optional, records timing of drawing when built with NGL_PROFILE, see nanogl/profile.h */
+	struct ngl_profiler *profiler;
+	/* Counters of drawing, read by ngl_get_stats */
+	ngl_stats_t stats;
 
 	void *priv;
 } ngl_driver_t;
 
+/* Worker pool running independent jobs */
+typedef struct ngl_executor {
+	/* Calls job for every index lower than count, returns when all jobs are finished */
+	ngl_executor_run_fn run;
+	/* Number of jobs running at same time */
+	size_t workers;
+
+	void *priv;
+} ngl_executor_t;
+
+/* Blocks drawing task until something changes */
+typedef struct ngl_scheduler {
+	/* Blocks until wake is called or timeout elapses, negative timeout waits forever, returns true if woken */
+	ngl_scheduler_wait_fn wait;
+	/* Wakes waiting task, can be called from any task */
+	ngl_scheduler_wake_fn wake;
+	/* Monotonic time in microseconds */
+	ngl_scheduler_now_fn now;
+
+	/* Minimal time between frames in microseconds */
+	int64_t frame_interval;
+	int64_t last_frame;
+	/* Time of frame requested by ngl_request_frame, INT64_MAX if none */
+	int64_t deadline;
+
+	void *priv;
+} ngl_scheduler_t;
+
 typedef struct ngl_widget {
 	ngl_area_t area;
+	/* Optional for pure containers */
 	ngl_widget_process_event_fn process_event;
+	/* NGL_WIDGET_* flags, can be changed by widget until draw of frame starts */
+	unsigned int flags;
+
+	/* Widget tree, children are drawn over parent */
+	struct ngl_widget *parent;
+	struct ngl_widget **children;
+	size_t child_count;
+	/* Cached bounding box of area and bounds of children */
+	ngl_area_t bounds;
 
 	void *priv;
 } ngl_widget_t;
@@ -80,6 +244,44 @@ typedef union ngl_color {
 } ngl_color_t;
 
 
+typedef enum ngl_command_type {
+	NGL_COMMAND_FILL,
+	NGL_COMMAND_PIXMAP,
+} ngl_command_type_t;
+
+typedef struct ngl_command {
+	ngl_command_type_t type;
+	/* Clipped area affected by command */
+	ngl_area_t bounds;
+	ngl_color_t color;
+	/* Pixmap source, must be valid until end of frame */
+	ngl_buffer_t *source;
+} ngl_command_t;
+
+typedef struct ngl_display_list {
+	ngl_command_t *commands;
+	size_t capacity;
+	size_t count;
+	/* Commands did not fit, frame is drawn directly */
+	bool overflow;
+} ngl_display_list_t;
+
+/* Bump allocator of transient data released at end of every frame */
+typedef struct ngl_frame_arena {
+	ngl_byte_t *data;
+	size_t size;
+	size_t used;
+	/* Bytes requested by current frame including allocations which didn't fit */
+	size_t requested;
+	/* Maximum of requested bytes over all frames, arena of this size never fails */
+	size_t high_water;
+	/* Number of failed allocations since init */
+	size_t failures;
+	/* Data is in caller storage */
+	bool static_storage;
+} ngl_frame_arena_t;
+
+
 /* Widget functions */
 typedef void (*ngl_on_draw_fn) (ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer);
 typedef void (*ngl_on_init_fn) (ngl_driver_t *driver, ngl_widget_t *widget, void *init_data);
@@ -100,19 +302,84 @@ typedef struct ngl_widget_event_table {
 void ngl_event_table_dispatch(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_event_table_t *table, ngl_event_t event, void *data);
 
 
+/* Initialize common driver state, width and height must be set */
+void ngl_driver_init(ngl_driver_t *driver);
+
+/* Release common driver state */
+void ngl_driver_destroy(ngl_driver_t *driver);
+
+/* Snapshot of drawing and display driver counters, can be called from any task */
+void ngl_get_stats(ngl_driver_t *driver, ngl_stats_t *stats);
+
+/* Use caller storage of NGL_SWEEP_STORAGE_SIZE(capacity) bytes for band culling
+ *
+ * Frames with more top level widgets than capacity draw all widgets to every band.
+ */
+void ngl_driver_set_sweep_storage(ngl_driver_t *driver, void *storage, size_t capacity);
+
+/* Allocate memory with heap_caps_malloc capabilities on ESP-IDF, caps 0 or other platforms use malloc */
+void *ngl_alloc(size_t size, uint32_t caps);
+
+/* Free memory allocated by ngl_alloc */
+void ngl_free(void *ptr);
+
+/* Initialize buffer structure */
+void ngl_buffer_init(ngl_buffer_t *buffer, ngl_area_t *area, ngl_byte_t *data, ngl_color_format_t format, ngl_driver_t *driver);
+
+/* View sharing pixels of buffer limited to area, returns false if view is empty
+ * or doesn't start at byte boundary of packed format */
+bool ngl_buffer_view(ngl_buffer_t *buffer, ngl_area_t *area, ngl_buffer_t *view);
+
+/* Restrict drawing to area until ngl_pop_clip, returns false if nothing remains visible */
+bool ngl_push_clip(ngl_buffer_t *buffer, ngl_area_t *area);
+
+/* Restore clip area before last ngl_push_clip */
+void ngl_pop_clip(ngl_buffer_t *buffer);
+
+/* Initialize display list with storage for capacity commands
+ *
+ * Display list is enabled by assigning it to driver->display_list. Widgets
+ * then must draw only using ngl_fill_area and ngl_draw_pixmap.
+ */
+void ngl_display_list_init(ngl_display_list_t *list, ngl_command_t *commands, size_t capacity);
+
+/* Allocate arena memory with capabilities of ngl_alloc, returns false if allocation fails
+ *
+ * Arena is enabled by assigning it to driver->arena.
+ */
+bool ngl_frame_arena_init(ngl_frame_arena_t *arena, size_t size, uint32_t caps);
+
+/* Initialize arena using caller storage */
+void ngl_frame_arena_init_static(ngl_frame_arena_t *arena, void *data, size_t size);
+
+/* Free arena memory */
+void ngl_frame_arena_destroy(ngl_frame_arena_t *arena);
+
+/* Release all allocations of arena, called by ngl_draw_frame after NGL_EVENT_FRAME_END */
+void ngl_frame_arena_reset(ngl_frame_arena_t *arena);
+
+/* Allocate memory from arena, align must be power of two, returns NULL if it doesn't fit */
+void *ngl_frame_arena_alloc(ngl_frame_arena_t *arena, size_t size, size_t align);
+
+/* Allocate memory valid until end of current frame, returns NULL without driver arena or if it doesn't fit */
+void *ngl_frame_alloc(ngl_driver_t *driver, size_t size, size_t align);
+
 /* Writes current buffer to device */
 void ngl_flush(ngl_driver_t *driver);
 
 /* Get next part of buffer in partial mode or secondary buffer in double buffer mode */
 ngl_buffer_t *ngl_get_buffer(ngl_driver_t *driver);
 
+/* Get buffer starting at top of area, driver must support windows */
+ngl_buffer_t *ngl_get_window(ngl_driver_t *driver, ngl_area_t *area);
+
 /* Get number of bits for each pixel of selected color format */
 unsigned short ngl_get_color_bits(ngl_color_format_t color);
 
 /* Send event to widget */
 void ngl_send_event(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data);
 
-/* Send events to widget list */
+/* Send events to widget list and their children, draw event is sent only to widgets intersecting buffer */
 void ngl_send_events(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count, ngl_event_t event, void *data);
 
 /* Initialize widget */
@@ -124,11 +391,55 @@ void ngl_widget_destroy(ngl_driver_t *driver, ngl_widget_t *widget);
 /* Reshape widget */
 void ngl_widget_reshape(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t area);
 
-/* Draw frame with widgets */
+/* Set children of widget, children must be initialized and must stay valid while they are attached */
+void ngl_widget_set_children(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_t **children, size_t count);
+
+/* Invalidate widget area */
+void ngl_widget_invalidate(ngl_driver_t *driver, ngl_widget_t *widget);
+
+/* Check if areas have common part */
+bool ngl_area_intersects(ngl_area_t *a, ngl_area_t *b);
+
+/* Calculate common part of areas, returns false if it's empty */
+bool ngl_area_intersection(ngl_area_t *a, ngl_area_t *b, ngl_area_t *result);
+
+/* Calculate bounding box of areas */
+void ngl_area_union(ngl_area_t *a, ngl_area_t *b, ngl_area_t *result);
+
+/* Mark area of screen to be redrawn in next frame */
+void ngl_invalidate_area(ngl_driver_t *driver, ngl_area_t *area);
+
+/* Mark whole screen to be redrawn in next frame */
+void ngl_invalidate(ngl_driver_t *driver);
+
+/* Initialize common scheduler state, max_fps 0 means unlimited frame rate */
+void ngl_scheduler_init(ngl_scheduler_t *scheduler, int max_fps);
+
+/* Draw frame after delay even if nothing is invalidated, used by animations */
+void ngl_request_frame(ngl_driver_t *driver, int64_t delay_us);
+
+/* Current time in microseconds from scheduler clock, 0 without scheduler */
+int64_t ngl_time(ngl_driver_t *driver);
+
+/* Wake drawing task waiting in ngl_wait_frame, can be called from any task */
+void ngl_wake(ngl_driver_t *driver);
+
+/* Block until area is invalidated, requested frame is due or task is woken, keeps maximum frame rate
+ *
+ * Returns immediately without scheduler. Returns true if frame has something to draw,
+ * false if task was only woken.
+ */
+bool ngl_wait_frame(ngl_driver_t *driver);
+
+/* Draw frame with widget trees, widgets must not draw outside of own area */
 void ngl_draw_frame(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count);
 
-/* Fill area with specific color */
+/* Fill area with specific color, translucent colors are blended over target */
 void ngl_fill_area(ngl_buffer_t *target, ngl_area_t *area, ngl_color_t color);
 
-/* Draw pixmap from source buffer to target buffer */
+/* Draw pixmap from source buffer placed at source area to target buffer, crop can be NULL
+ *
+ * Mono and gray sources are masks drawn with color, other sources are
+ * multiplied by color and blended using own alpha channel.
+ */
 void ngl_draw_pixmap(ngl_buffer_t *target, ngl_buffer_t *source, ngl_area_t *crop, ngl_color_t color);
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+/* Animation progress is fixed point number with 16 fractional bits */
+#define NGL_ANIMATION_ONE 65536
+
+typedef enum ngl_easing {
+	NGL_EASING_LINEAR,
+	NGL_EASING_IN_QUAD,
+	NGL_EASING_OUT_QUAD,
+	NGL_EASING_IN_OUT_QUAD,
+	NGL_EASING_IN_OUT_CUBIC,
+} ngl_easing_t;
+
+typedef enum ngl_animation_property {
+	NGL_ANIMATION_AREA,
+	NGL_ANIMATION_COLOR,
+} ngl_animation_property_t;
+
+struct ngl_animation;
+
+typedef void (*ngl_animation_done_fn) (ngl_driver_t *driver, struct ngl_animation *animation);
+
+/* Animation of single widget property, storage is owned by caller */
+typedef struct ngl_animation {
+	ngl_widget_t *widget;
+	ngl_animation_property_t property;
+	ngl_easing_t easing;
+	/* Start time and duration in microseconds */
+	int64_t start;
+	int64_t duration;
+	union {
+		struct {
+			ngl_area_t from;
+			ngl_area_t to;
+		} area;
+		struct {
+			/* Animated color, usually part of widget data */
+			ngl_color_t *target;
+			ngl_color_t from;
+			ngl_color_t to;
+		} color;
+	};
+	/* Optional, called after last step */
+	ngl_animation_done_fn done;
+	void *user_data;
+
+	bool running;
+	struct ngl_animation *next;
+} ngl_animation_t;
+
+
+/* Map linear progress to eased progress, both in range 0 - NGL_ANIMATION_ONE */
+int32_t ngl_ease(ngl_easing_t easing, int32_t progress);
+
+/* Prepare animation of widget area to target area */
+void ngl_animation_area_init(ngl_animation_t *animation, ngl_widget_t *widget, ngl_area_t *to, int64_t duration, ngl_easing_t easing);
+
+/* Prepare animation of color owned by widget */
+void ngl_animation_color_init(ngl_animation_t *animation, ngl_widget_t *widget, ngl_color_t *color, ngl_color_t to, int64_t duration, ngl_easing_t easing);
+
+/* Start animation from current value, driver must have scheduler used as clock */
+void ngl_animation_start(ngl_driver_t *driver, ngl_animation_t *animation);
+
+/* Stop animation at current value */
+void ngl_animation_stop(ngl_driver_t *driver, ngl_animation_t *animation);
+
+/* Apply all running animations, called by ngl_draw_frame before frame start */
+void ngl_animations_update(ngl_driver_t *driver);
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+struct ngl_batch;
+
+/* Draw all instances of batch intersecting buffer */
+typedef void (*ngl_batch_draw_fn) (ngl_driver_t *driver, struct ngl_batch *batch, ngl_buffer_t *buffer);
+
+/* Many instances of one widget type stored in arrays and drawn by single call */
+typedef struct ngl_batch {
+	ngl_batch_draw_fn draw;
+	/* Area of every instance */
+	ngl_area_t *areas;
+	/* Type specific array with state_size bytes for every instance */
+	void *state;
+	size_t state_size;
+	size_t count;
+	size_t capacity;
+	/* Instance was moved or removed, bounds are recalculated at frame start */
+	bool bounds_dirty;
+} ngl_batch_t;
+
+
+/* Initialize batch widget with storage for capacity instances */
+void ngl_batch_init(ngl_driver_t *driver, ngl_widget_t *widget, ngl_batch_t *batch, ngl_batch_draw_fn draw, ngl_area_t *areas, void *state, size_t state_size, size_t capacity);
+
+/* Append instance, returns its index or -1 if batch is full, state of instance must be set by caller */
+int ngl_batch_add(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t *area);
+
+/* Remove instance, last instance is moved to its index */
+void ngl_batch_remove(ngl_driver_t *driver, ngl_widget_t *widget, size_t index);
+
+/* Move instance */
+void ngl_batch_set_area(ngl_driver_t *driver, ngl_widget_t *widget, size_t index, ngl_area_t *area);
+
+/* Redraw instance after change of its state */
+void ngl_batch_invalidate(ngl_driver_t *driver, ngl_widget_t *widget, size_t index);
+
+void ngl_widget_batch(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data);
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+struct ngl_widget_cache;
+
+/* Memory shared by cached surfaces, least recently used surfaces are released when budget is exceeded */
+typedef struct ngl_surface_cache {
+	/* Capabilities of surface memory passed to ngl_alloc, e.g. MALLOC_CAP_SPIRAM */
+	uint32_t caps;
+	/* Maximum size of all surfaces in bytes */
+	size_t budget;
+	size_t used;
+	/* Surfaces ordered from most recently used */
+	struct ngl_widget_cache *first;
+	struct ngl_widget_cache *last;
+} ngl_surface_cache_t;
+
+/* State of cached widget, storage is owned by caller */
+typedef struct ngl_widget_cache {
+	ngl_surface_cache_t *cache;
+	ngl_color_format_t format;
+	/* Rendered children, pixels are allocated only while surface is cached */
+	ngl_buffer_t surface;
+	size_t size;
+	/* Children changed since surface was rendered */
+	bool stale;
+	/* Frame of last use, surfaces used by current frame are never released */
+	uint64_t frame;
+	struct ngl_widget_cache *prev;
+	struct ngl_widget_cache *next;
+} ngl_widget_cache_t;
+
+
+/* Initialize cache with budget in bytes */
+void ngl_surface_cache_init(ngl_surface_cache_t *cache, size_t budget, uint32_t caps);
+
+/* Release all surfaces, cached widgets stay valid and allocate surfaces again when drawn */
+void ngl_surface_cache_destroy(ngl_surface_cache_t *cache);
+
+/* Initialize cached widget
+ *
+ * Children of widget are rendered once to offscreen surface in format and
+ * the surface is blitted to screen until some child is invalidated. Children
+ * are clipped to area of widget. Surface is cleared to transparent color, so
+ * format without alpha channel needs children covering whole area. If the
+ * surface doesn't fit to budget, children are drawn directly.
+ */
+void ngl_widget_cache_init(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_cache_t *cached, ngl_surface_cache_t *cache, ngl_color_format_t format, ngl_area_t *area);
+
+void ngl_widget_cache(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data);
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+typedef struct ngl_memory_driver_init_struct {
+	int width;
+	int height;
+	ngl_color_format_t format;
+	/* Maximum height of band, 0 renders whole screen at once */
+	int band_lines;
+	/* Redraw only dirty windows, packed formats always redraw whole screen */
+	bool windows;
+	/* Optional caller storage for whole screen, allocated if NULL */
+	ngl_byte_t *framebuffer;
+} ngl_memory_driver_init_struct_t;
+
+/* Statistics of flushed bands */
+typedef struct ngl_memory_driver_stats {
+	uint64_t bands;
+	uint64_t pixels;
+} ngl_memory_driver_stats_t;
+
+
+/* Initialize driver rendering to framebuffer in memory, returns false if framebuffer can't be allocated */
+bool ngl_memory_driver_init(ngl_driver_t *driver, ngl_memory_driver_init_struct_t *config);
+
+/* Release driver and allocated framebuffer */
+void ngl_memory_driver_destroy(ngl_driver_t *driver);
+
+/* Whole screen, lines are continuous */
+ngl_buffer_t *ngl_memory_driver_framebuffer(ngl_driver_t *driver);
+
+ngl_memory_driver_stats_t *ngl_memory_driver_stats(ngl_driver_t *driver);
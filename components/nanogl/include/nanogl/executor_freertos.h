@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "nanogl.h"
+
+
+#define NGL_FREERTOS_EXECUTOR_STACK_SIZE (configMINIMAL_STACK_SIZE + 2048)
+
+/* Upper bound of private structure size, checked at compile time */
+#define NGL_FREERTOS_EXECUTOR_PRIV_SIZE (4 * sizeof(void *) + 4 * sizeof(size_t))
+
+/* Bytes of storage for ngl_freertos_executor_init_static, helper stacks included */
+#define NGL_FREERTOS_EXECUTOR_STORAGE_SIZE(workers) (NGL_STORAGE_ALIGN - 1 + \
+	NGL_STORAGE_ROUND(NGL_FREERTOS_EXECUTOR_PRIV_SIZE) + \
+	NGL_STORAGE_ROUND(sizeof(StaticSemaphore_t)) + \
+	NGL_STORAGE_ROUND((workers) * sizeof(TaskHandle_t)) + \
+	((workers) > 1 ? (workers) - 1 : 0) * (NGL_STORAGE_ROUND(sizeof(StaticTask_t)) + NGL_STORAGE_ROUND(NGL_FREERTOS_EXECUTOR_STACK_SIZE * sizeof(StackType_t))))
+
+
+/* Initialize executor with workers - 1 helper tasks, calling task runs jobs too
+ *
+ * Helpers are pinned to cores following the first one and run with priority
+ * of calling task. Returns false if tasks can't be created.
+ */
+bool ngl_freertos_executor_init(ngl_executor_t *executor, size_t workers);
+/* Initialize executor without heap, tasks and semaphore live in caller storage of NGL_FREERTOS_EXECUTOR_STORAGE_SIZE(workers) bytes */
+bool ngl_freertos_executor_init_static(ngl_executor_t *executor, size_t workers, void *storage, size_t storage_size);
+
+/* Stop helper tasks */
+void ngl_freertos_executor_destroy(ngl_executor_t *executor);
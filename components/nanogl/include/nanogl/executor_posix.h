@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+/* Initialize executor with workers - 1 helper threads, calling thread runs jobs too
+ *
+ * Returns false if threads can't be created.
+ */
+bool ngl_posix_executor_init(ngl_executor_t *executor, size_t workers);
+
+/* Stop helper threads */
+void ngl_posix_executor_destroy(ngl_executor_t *executor);
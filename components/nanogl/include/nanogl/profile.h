@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdio.h>
+
+#include "nanogl.h"
+
+
+/* Maximum number of named subjects of profiler */
+#ifndef NGL_PROFILE_LABELS_MAX
+#define NGL_PROFILE_LABELS_MAX 16
+#endif
+
+/* Maximum number of rows of profiler summary */
+#ifndef NGL_PROFILE_SUMMARY_MAX
+#define NGL_PROFILE_SUMMARY_MAX 32
+#endif
+
+/*
+ * Instrumentation is compiled only with NGL_PROFILE defined and records
+ * spans only to profiler assigned to driver->profiler.
+ */
+#ifdef NGL_PROFILE
+#define NGL_PROFILE_BEGIN(driver, span) const int64_t span = ngl_profile_begin(driver)
+#define NGL_PROFILE_END(driver, span, kind, subject, value) ngl_profile_end(driver, span, kind, subject, value)
+#else
+#define NGL_PROFILE_BEGIN(driver, span) ((void)0)
+#define NGL_PROFILE_END(driver, span, kind, subject, value) ((void)0)
+#endif
+
+typedef enum ngl_profile_kind {
+	/* Whole ngl_draw_frame, value is frame number */
+	NGL_PROFILE_FRAME,
+	/* Event sent to widget, value is ngl_event_t */
+	NGL_PROFILE_EVENT,
+	/* Recording of display list, value is number of commands */
+	NGL_PROFILE_RECORD,
+	/* Band from get_buffer to flush, value is first line */
+	NGL_PROFILE_BAND,
+	/* Tile of band replayed by executor, value is tile index */
+	NGL_PROFILE_TILE,
+	/* Driver get_buffer or get_window */
+	NGL_PROFILE_GET_BUFFER,
+	/* Driver flush */
+	NGL_PROFILE_FLUSH,
+	/* Conversion of band to display format, value is number of pixels */
+	NGL_PROFILE_CONVERT,
+	/* Waiting for free transfer buffer, value is driver specific */
+	NGL_PROFILE_QUEUE_WAIT,
+	NGL_PROFILE_KIND_COUNT,
+} ngl_profile_kind_t;
+
+/* Finished span */
+typedef struct ngl_profile_record {
+	/* Start time and duration in nanoseconds */
+	int64_t start;
+	uint32_t duration;
+	uint16_t kind;
+	/* Core on device, sequence number of thread on host */
+	uint16_t thread;
+	/* Widget or other object measured by span, can be NULL */
+	const void *subject;
+	int32_t value;
+} ngl_profile_record_t;
+
+typedef struct ngl_profile_label {
+	const void *subject;
+	const char *name;
+} ngl_profile_label_t;
+
+/* Ring buffer of spans written without locks from any task, oldest spans are overwritten */
+typedef struct ngl_profiler {
+	ngl_profile_record_t *records;
+	/* Power of two */
+	size_t capacity;
+	/* Number of spans written since clear */
+	size_t head;
+	/* Spans are recorded only while enabled */
+	bool enabled;
+	ngl_profile_label_t labels[NGL_PROFILE_LABELS_MAX];
+	size_t label_count;
+} ngl_profiler_t;
+
+
+/* Initialize profiler with storage for capacity spans, capacity must be power of two
+ *
+ * Profiler is enabled by assigning it to driver->profiler.
+ */
+void ngl_profiler_init(ngl_profiler_t *profiler, ngl_profile_record_t *records, size_t capacity);
+
+/* Drop all recorded spans */
+void ngl_profiler_clear(ngl_profiler_t *profiler);
+
+/* Name widget or other subject in exported data, name must stay valid */
+void ngl_profiler_label(ngl_profiler_t *profiler, const void *subject, const char *name);
+
+/* Write spans as Chrome trace JSON readable by Perfetto and chrome://tracing
+ *
+ * Profiler should be disabled while writing, spans recorded concurrently can be torn.
+ */
+void ngl_profiler_write_trace(ngl_profiler_t *profiler, FILE *out);
+
+/* Write total, mean and maximum time of every kind and subject as text, suitable for UART console */
+void ngl_profiler_write_summary(ngl_profiler_t *profiler, FILE *out);
+
+/* Current time of profiler clock in nanoseconds, 0 if driver has no enabled profiler */
+int64_t ngl_profile_begin(ngl_driver_t *driver);
+
+/* Record span started by ngl_profile_begin */
+void ngl_profile_end(ngl_driver_t *driver, int64_t start, ngl_profile_kind_t kind, const void *subject, int32_t value);
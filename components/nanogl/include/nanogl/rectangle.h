@@ -3,9 +3,13 @@
 #pragma once
 
 #include "nanogl.h"
+#include "nanogl/batch.h"
 
 
 typedef ngl_color_t ngl_widget_rectangle_data_t;
 typedef ngl_rgba_t ngl_widget_rectangle_init_t;
 
 void ngl_widget_rectangle(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data);
+
+/* Batch draw function, state is array of ngl_widget_rectangle_data_t */
+void ngl_widget_rectangle_batch_draw(ngl_driver_t *driver, ngl_batch_t *batch, ngl_buffer_t *buffer);
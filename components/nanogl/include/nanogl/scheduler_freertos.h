@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "nanogl.h"
+
+
+/* Bytes of storage for ngl_freertos_scheduler_init_static */
+#define NGL_FREERTOS_SCHEDULER_STORAGE_SIZE (NGL_STORAGE_ALIGN - 1 + NGL_STORAGE_ROUND(sizeof(StaticSemaphore_t)))
+
+
+/* Initialize scheduler waiting on binary semaphore, returns false if semaphore can't be created */
+bool ngl_freertos_scheduler_init(ngl_scheduler_t *scheduler, int max_fps);
+/* Initialize scheduler with semaphore in caller storage of NGL_FREERTOS_SCHEDULER_STORAGE_SIZE bytes */
+bool ngl_freertos_scheduler_init_static(ngl_scheduler_t *scheduler, int max_fps, void *storage, size_t storage_size);
+
+void ngl_freertos_scheduler_destroy(ngl_scheduler_t *scheduler);
@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "nanogl.h"
+
+
+/* Initialize scheduler waiting on condition variable, returns false if it can't be allocated */
+bool ngl_posix_scheduler_init(ngl_scheduler_t *scheduler, int max_fps);
+
+void ngl_posix_scheduler_destroy(ngl_scheduler_t *scheduler);
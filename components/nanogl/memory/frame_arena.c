@@ -0,0 +1,68 @@
+#include "nanogl.h"
+
+
+bool ngl_frame_arena_init(ngl_frame_arena_t *arena, size_t size, uint32_t caps) {
+	arena->data = (ngl_byte_t *)ngl_alloc(size, caps);
+	arena->size = arena->data == NULL ? 0 : size;
+	arena->used = 0;
+	arena->requested = 0;
+	arena->high_water = 0;
+	arena->failures = 0;
+	arena->static_storage = false;
+	return arena->data != NULL;
+}
+
+
+void ngl_frame_arena_init_static(ngl_frame_arena_t *arena, void *data, size_t size) {
+	arena->data = (ngl_byte_t *)data;
+	arena->size = size;
+	arena->used = 0;
+	arena->requested = 0;
+	arena->high_water = 0;
+	arena->failures = 0;
+	arena->static_storage = true;
+}
+
+
+void ngl_frame_arena_destroy(ngl_frame_arena_t *arena) {
+	if (!arena->static_storage) {
+		ngl_free(arena->data);
+	}
+	arena->data = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
+
+
+void ngl_frame_arena_reset(ngl_frame_arena_t *arena) {
+	arena->used = 0;
+	arena->requested = 0;
+}
+
+
+void *ngl_frame_arena_alloc(ngl_frame_arena_t *arena, size_t size, size_t align) {
+	assert(align != 0 && (align & (align - 1)) == 0);
+
+	// Alignment of address, arena memory doesn't need to be aligned
+	const size_t padding = (-(uintptr_t)(arena->data + arena->used)) & (align - 1);
+	arena->requested += padding + size;
+	if (arena->requested > arena->high_water) {
+		arena->high_water = arena->requested;
+	}
+	if (arena->data == NULL || padding + size > arena->size - arena->used) {
+		arena->failures++;
+		return NULL;
+	}
+
+	void *result = arena->data + arena->used + padding;
+	arena->used += padding + size;
+	return result;
+}
+
+
+void *ngl_frame_alloc(ngl_driver_t *driver, size_t size, size_t align) {
+	if (driver->arena == NULL) {
+		return NULL;
+	}
+	return ngl_frame_arena_alloc(driver->arena, size, align);
+}
@@ -1,8 +1,22 @@
 // SPDX-License-Identifier: MIT
 #include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/param.h>
 
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
 #include "nanogl.h"
+#include "nanogl/animation.h"
+#include "nanogl/cache.h"
+#include "nanogl/profile.h"
+
+
+static void ngl_display_list_replay(ngl_display_list_t *list, ngl_buffer_t *target);
+static void ngl_widget_invalidate_caches(ngl_widget_t *widget);
 
 
 void ngl_event_table_dispatch(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_event_table_t *table, ngl_event_t event, void *data) {
@@ -45,13 +59,171 @@ void ngl_event_table_dispatch(ngl_driver_t *driver, ngl_widget_t *widget, ngl_wi
 }
 
 
+void ngl_driver_init(ngl_driver_t *driver) {
+	driver->frame = 0;
+	driver->display_list = NULL;
+	driver->executor = NULL;
+	driver->scheduler = NULL;
+	driver->animations = NULL;
+	driver->arena = NULL;
+	driver->profiler = NULL;
+	memset(&driver->stats, 0, sizeof(driver->stats));
+	driver->sweep.order = NULL;
+	driver->sweep.active = NULL;
+	driver->sweep.clips = NULL;
+	driver->sweep.occluders = NULL;
+	driver->sweep.capacity = 0;
+	driver->sweep.count = 0;
+	driver->sweep.static_storage = false;
+	ngl_invalidate(driver);
+}
+
+
+void ngl_driver_destroy(ngl_driver_t *driver) {
+	if (!driver->sweep.static_storage) {
+		free(driver->sweep.order);
+		free(driver->sweep.active);
+		free(driver->sweep.clips);
+		free(driver->sweep.occluders);
+	}
+	driver->sweep.order = NULL;
+	driver->sweep.active = NULL;
+	driver->sweep.clips = NULL;
+	driver->sweep.occluders = NULL;
+	driver->sweep.capacity = 0;
+	driver->sweep.count = 0;
+	driver->sweep.static_storage = false;
+}
+
+
+/* Take aligned part of caller storage, storage size is checked by sizing macros */
+static void *ngl_storage_take(ngl_byte_t **storage, size_t size) {
+	ngl_byte_t *part = (ngl_byte_t *)NGL_STORAGE_ROUND((uintptr_t)*storage);
+	*storage = part + NGL_STORAGE_ROUND(size);
+	return part;
+}
+
+
+void ngl_driver_set_sweep_storage(ngl_driver_t *driver, void *storage, size_t capacity) {
+	ngl_driver_destroy(driver);
+	ngl_byte_t *data = (ngl_byte_t *)storage;
+	driver->sweep.order = (size_t *)ngl_storage_take(&data, capacity * sizeof(size_t));
+	driver->sweep.active = (size_t *)ngl_storage_take(&data, capacity * sizeof(size_t));
+	driver->sweep.clips = (ngl_area_t *)ngl_storage_take(&data, capacity * sizeof(ngl_area_t));
+	driver->sweep.occluders = (ngl_area_t *)ngl_storage_take(&data, capacity * sizeof(ngl_area_t));
+	driver->sweep.capacity = capacity;
+	driver->sweep.static_storage = true;
+}
+
+
+void *ngl_alloc(size_t size, uint32_t caps) {
+#ifdef ESP_PLATFORM
+	if (caps != 0) {
+		return heap_caps_malloc(size, caps);
+	}
+#endif
+	return malloc(size);
+}
+
+
+void ngl_free(void *ptr) {
+	// heap_caps_malloc memory is released by free too
+	free(ptr);
+}
+
+
+void ngl_buffer_init(ngl_buffer_t *buffer, ngl_area_t *area, ngl_byte_t *data, ngl_color_format_t format, ngl_driver_t *driver) {
+	buffer->area = *area;
+	buffer->buffer = data;
+	buffer->stride = area->width;
+	buffer->format = format;
+	buffer->driver = driver;
+	buffer->recorder = NULL;
+	buffer->clip = *area;
+	buffer->clip_depth = 0;
+}
+
+
+bool ngl_buffer_view(ngl_buffer_t *buffer, ngl_area_t *area, ngl_buffer_t *view) {
+	ngl_area_t view_area;
+	if (!ngl_area_intersection(&buffer->area, area, &view_area)) {
+		return false;
+	}
+	const size_t offset_bits = ((size_t)(view_area.x - buffer->area.x) + (size_t)(view_area.y - buffer->area.y) * buffer->stride) * ngl_get_color_bits(buffer->format);
+	if (offset_bits & 0x07) {
+		return false;
+	}
+	ngl_buffer_init(view, &view_area, buffer->buffer == NULL ? NULL : buffer->buffer + (offset_bits >> 3), buffer->format, buffer->driver);
+	view->stride = buffer->stride;
+	view->recorder = buffer->recorder;
+	if (!ngl_area_intersection(&view_area, &buffer->clip, &view->clip)) {
+		view->clip.width = 0;
+		view->clip.height = 0;
+	}
+	return true;
+}
+
+
+/* Drivers reuse buffer structures with new area */
+static ngl_buffer_t *ngl_buffer_reset_clip(ngl_buffer_t *buffer) {
+	buffer->clip = buffer->area;
+	buffer->clip_depth = 0;
+	return buffer;
+}
+
+
+bool ngl_push_clip(ngl_buffer_t *buffer, ngl_area_t *area) {
+	assert(buffer->clip_depth < NGL_CLIP_STACK_MAX);
+	buffer->clip_stack[buffer->clip_depth++] = buffer->clip;
+	if (!ngl_area_intersection(&buffer->clip, area, &buffer->clip)) {
+		buffer->clip.width = 0;
+		buffer->clip.height = 0;
+		return false;
+	}
+	return true;
+}
+
+
+void ngl_pop_clip(ngl_buffer_t *buffer) {
+	assert(buffer->clip_depth > 0);
+	buffer->clip = buffer->clip_stack[--buffer->clip_depth];
+}
+
+
+void ngl_get_stats(ngl_driver_t *driver, ngl_stats_t *stats) {
+	*stats = driver->stats;
+	if (driver->arena != NULL) {
+		stats->arena_size = driver->arena->size;
+		stats->arena_high_water = driver->arena->high_water;
+		stats->arena_failures = driver->arena->failures;
+	}
+	if (driver->get_stats != NULL) {
+		driver->get_stats(driver, stats);
+	}
+}
+
+
 void ngl_flush(ngl_driver_t *driver) {
+	NGL_PROFILE_BEGIN(driver, span);
+	driver->stats.bands++;
 	driver->flush(driver);
+	NGL_PROFILE_END(driver, span, NGL_PROFILE_FLUSH, NULL, 0);
 }
 
 
 ngl_buffer_t *ngl_get_buffer(ngl_driver_t *driver) {
-	return driver->get_buffer(driver);
+	NGL_PROFILE_BEGIN(driver, span);
+	ngl_buffer_t *buffer = driver->get_buffer(driver);
+	NGL_PROFILE_END(driver, span, NGL_PROFILE_GET_BUFFER, NULL, buffer->area.y);
+	return ngl_buffer_reset_clip(buffer);
+}
+
+
+ngl_buffer_t *ngl_get_window(ngl_driver_t *driver, ngl_area_t *area) {
+	NGL_PROFILE_BEGIN(driver, span);
+	ngl_buffer_t *buffer = driver->get_window(driver, area);
+	NGL_PROFILE_END(driver, span, NGL_PROFILE_GET_BUFFER, NULL, buffer->area.y);
+	return ngl_buffer_reset_clip(buffer);
 }
 
 
@@ -75,13 +247,74 @@ unsigned short ngl_get_color_bits(ngl_color_format_t color) {
 
 
 void ngl_send_event(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
-	widget->process_event(driver, widget, event, data);
+	if (widget->process_event != NULL) {
+		NGL_PROFILE_BEGIN(driver, span);
+		widget->process_event(driver, widget, event, data);
+		NGL_PROFILE_END(driver, span, NGL_PROFILE_EVENT, widget, event);
+	}
+}
+
+
+/* Draw widget and children intersecting clip of buffer, subtrees outside of clip are skipped */
+static void ngl_draw_tree(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buf) {
+	if (ngl_area_intersects(&widget->area, &buf->clip)) {
+		ngl_send_event(driver, widget, NGL_EVENT_DRAW, buf);
+	}
+	// Cached widget draws children itself
+	if (widget->child_count == 0 || (widget->flags & NGL_WIDGET_CACHED)) {
+		return;
+	}
+	const bool clip = (widget->flags & NGL_WIDGET_CLIP_CHILDREN) != 0;
+	if (clip && !ngl_push_clip(buf, &widget->area)) {
+		ngl_pop_clip(buf);
+		return;
+	}
+	for (size_t i = 0; i < widget->child_count; ++i) {
+		ngl_widget_t *child = widget->children[i];
+		if (ngl_area_intersects(&child->bounds, &buf->clip)) {
+			ngl_draw_tree(driver, child, buf);
+		}
+	}
+	if (clip) {
+		ngl_pop_clip(buf);
+	}
 }
 
 
 void ngl_send_events(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count, ngl_event_t event, void *data) {
 	for (size_t i = 0; i < count; ++i) {
-		ngl_send_event(driver, widgets[i], event, data);
+		ngl_widget_t *widget = widgets[i];
+		if (event == NGL_EVENT_DRAW) {
+			if (ngl_area_intersects(&widget->bounds, &((ngl_buffer_t *)data)->clip)) {
+				ngl_draw_tree(driver, widget, (ngl_buffer_t *)data);
+			}
+		}
+		else {
+			ngl_send_event(driver, widget, event, data);
+			ngl_send_events(driver, widget->children, widget->child_count, event, data);
+		}
+	}
+}
+
+
+/* Recalculate bounds of widget and its ancestors */
+static void ngl_widget_update_bounds(ngl_widget_t *widget) {
+	while (widget != NULL) {
+		ngl_area_t bounds = widget->area;
+		for (size_t i = 0; i < widget->child_count; ++i) {
+			ngl_area_t *child_bounds = &widget->children[i]->bounds;
+			if (child_bounds->width <= 0 || child_bounds->height <= 0) {
+				continue;
+			}
+			if (bounds.width <= 0 || bounds.height <= 0) {
+				bounds = *child_bounds;
+			}
+			else {
+				ngl_area_union(&bounds, child_bounds, &bounds);
+			}
+		}
+		widget->bounds = bounds;
+		widget = widget->parent;
 	}
 }
 
@@ -89,75 +322,593 @@ void ngl_send_events(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count,
 void ngl_widget_init(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_process_event_fn process_event, ngl_area_t *area, void *widget_priv, void *init_data) {
 	widget->process_event = process_event;
 	widget->area = *area;
+	widget->flags = 0;
+	widget->parent = NULL;
+	widget->children = NULL;
+	widget->child_count = 0;
+	widget->bounds = *area;
 	widget->priv = widget_priv;
 	ngl_send_event(driver, widget, NGL_EVENT_INIT, init_data);
 	ngl_send_event(driver, widget, NGL_EVENT_RESHAPE, &widget->area);
+	ngl_widget_invalidate(driver, widget);
 }
 
 
 void ngl_widget_destroy(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_widget_invalidate(driver, widget);
 	ngl_send_event(driver, widget, NGL_EVENT_DESTROY, NULL);
 }
 
 
 void ngl_widget_reshape(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t area) {
-	ngl_send_event(driver, widget, NGL_EVENT_RESHAPE, &area);
+	ngl_widget_invalidate(driver, widget);
+	widget->area = area;
+	ngl_widget_update_bounds(widget);
+	ngl_send_event(driver, widget, NGL_EVENT_RESHAPE, &widget->area);
+	ngl_widget_invalidate(driver, widget);
 }
 
 
-void ngl_draw_frame(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count) {
-	driver->frame++;
+void ngl_widget_set_children(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_t **children, size_t count) {
+	ngl_invalidate_area(driver, &widget->bounds);
+	for (size_t i = 0; i < widget->child_count; ++i) {
+		widget->children[i]->parent = NULL;
+	}
+	widget->children = children;
+	widget->child_count = count;
+	for (size_t i = 0; i < count; ++i) {
+		children[i]->parent = widget;
+	}
+	ngl_widget_update_bounds(widget);
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &widget->bounds);
+}
 
-	ngl_send_events(driver, widgets, count, NGL_EVENT_FRAME_START, NULL);
 
-	ngl_buffer_t *buf;
+void ngl_widget_invalidate(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &widget->area);
+}
+
+
+bool ngl_area_intersects(ngl_area_t *a, ngl_area_t *b) {
+	return
+		a->x < b->x + b->width &&
+		a->y < b->y + b->height &&
+		b->x < a->x + a->width &&
+		b->y < a->y + a->height;
+}
+
+
+bool ngl_area_intersection(ngl_area_t *a, ngl_area_t *b, ngl_area_t *result) {
+	const int x = MAX(a->x, b->x);
+	const int y = MAX(a->y, b->y);
+	const int width = MIN(a->x + a->width, b->x + b->width) - x;
+	const int height = MIN(a->y + a->height, b->y + b->height) - y;
+	if (width <= 0 || height <= 0) {
+		return false;
+	}
+	result->x = x;
+	result->y = y;
+	result->width = width;
+	result->height = height;
+	return true;
+}
+
+
+void ngl_area_union(ngl_area_t *a, ngl_area_t *b, ngl_area_t *result) {
+	const int x = MIN(a->x, b->x);
+	const int y = MIN(a->y, b->y);
+	result->width = MAX(a->x + a->width, b->x + b->width) - x;
+	result->height = MAX(a->y + a->height, b->y + b->height) - y;
+	result->x = x;
+	result->y = y;
+}
+
+
+static inline long ngl_area_size(ngl_area_t *area) {
+	return (long)area->width * (long)area->height;
+}
+
+
+void ngl_invalidate_area(ngl_driver_t *driver, ngl_area_t *area) {
+	ngl_dirty_region_t *dirty = &driver->dirty;
+	ngl_area_t screen = {0, 0, driver->width, driver->height};
+	ngl_area_t merged;
+	if (!ngl_area_intersection(&screen, area, &merged)) {
+		return;
+	}
+
+	// Merge with every rectangle which does not enlarge redrawn surface
+	size_t i = 0;
+	while (i < dirty->count) {
+		ngl_area_t candidate;
+		ngl_area_union(&merged, &dirty->areas[i], &candidate);
+		if (ngl_area_size(&candidate) <= ngl_area_size(&merged) + ngl_area_size(&dirty->areas[i])) {
+			merged = candidate;
+			dirty->areas[i] = dirty->areas[--dirty->count];
+			i = 0;
+		}
+		else {
+			i++;
+		}
+	}
+
+	if (dirty->count < NGL_DIRTY_AREAS_MAX) {
+		dirty->areas[dirty->count++] = merged;
+		return;
+	}
+
+	// All slots used, merge with rectangle with smallest growth
+	size_t best = 0;
+	long best_growth = LONG_MAX;
+	for (i = 0; i < dirty->count; ++i) {
+		ngl_area_t candidate;
+		ngl_area_union(&merged, &dirty->areas[i], &candidate);
+		const long growth = ngl_area_size(&candidate) - ngl_area_size(&dirty->areas[i]);
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+	ngl_area_union(&merged, &dirty->areas[best], &dirty->areas[best]);
+}
+
+
+void ngl_invalidate(ngl_driver_t *driver) {
+	driver->dirty.count = 1;
+	driver->dirty.areas[0].x = 0;
+	driver->dirty.areas[0].y = 0;
+	driver->dirty.areas[0].width = driver->width;
+	driver->dirty.areas[0].height = driver->height;
+}
+
+
+/* Find next run of dirty lines starting at or below y */
+static bool ngl_dirty_next_window(ngl_dirty_region_t *dirty, int y, ngl_area_t *window) {
+	int start = INT_MAX;
+	for (size_t i = 0; i < dirty->count; ++i) {
+		ngl_area_t *area = &dirty->areas[i];
+		if (area->y + area->height > y) {
+			start = MIN(start, MAX(area->y, y));
+		}
+	}
+	if (start == INT_MAX) {
+		return false;
+	}
+
+	int end = start;
+	int left = INT_MAX;
+	int right = INT_MIN;
+	bool extended;
 	do {
-		buf = ngl_get_buffer(driver);
-		ngl_send_events(driver, widgets, count, NGL_EVENT_DRAW, buf);
-		ngl_flush(driver);
-	} while (buf->area.y + buf->area.height < driver->height);
+		extended = false;
+		for (size_t i = 0; i < dirty->count; ++i) {
+			ngl_area_t *area = &dirty->areas[i];
+			if (area->y <= end && area->y + area->height > start) {
+				left = MIN(left, area->x);
+				right = MAX(right, area->x + area->width);
+				if (area->y + area->height > end) {
+					end = area->y + area->height;
+					extended = true;
+				}
+			}
+		}
+	} while (extended);
 
-	ngl_send_events(driver, widgets, count, NGL_EVENT_FRAME_END, NULL);
+	window->x = left;
+	window->y = start;
+	window->width = right - left;
+	window->height = end - start;
+	return true;
 }
 
 
-void ngl_fill_area(ngl_buffer_t *target, ngl_area_t *area, ngl_color_t color) {
-	assert(target->format == NGL_RGBA);
+void ngl_scheduler_init(ngl_scheduler_t *scheduler, int max_fps) {
+	scheduler->frame_interval = max_fps > 0 ? 1000000 / max_fps : 0;
+	scheduler->last_frame = INT64_MIN;
+	scheduler->deadline = INT64_MAX;
+}
+
 
-	// Check draw outside area
-	if (
-		area->x >= target->area.x + target->area.width ||
-		area->y >= target->area.y + target->area.height ||
-		area->x + area->width <= target->area.x ||
-		area->y + area->height <= target->area.y
-	) {
+void ngl_request_frame(ngl_driver_t *driver, int64_t delay_us) {
+	ngl_scheduler_t *scheduler = driver->scheduler;
+	if (scheduler == NULL) {
 		return;
 	}
+	const int64_t deadline = scheduler->now(scheduler) + delay_us;
+	if (deadline < scheduler->deadline) {
+		scheduler->deadline = deadline;
+	}
+}
+
+
+int64_t ngl_time(ngl_driver_t *driver) {
+	if (driver->scheduler == NULL) {
+		return 0;
+	}
+	return driver->scheduler->now(driver->scheduler);
+}
+
+
+void ngl_wake(ngl_driver_t *driver) {
+	if (driver->scheduler != NULL) {
+		driver->scheduler->wake(driver->scheduler);
+	}
+}
+
+
+bool ngl_wait_frame(ngl_driver_t *driver) {
+	ngl_scheduler_t *scheduler = driver->scheduler;
+	if (scheduler == NULL) {
+		return true;
+	}
+
+	bool woken = false;
+	int64_t now = scheduler->now(scheduler);
+	while (driver->dirty.count == 0 && now < scheduler->deadline && !woken) {
+		woken = scheduler->wait(scheduler, scheduler->deadline == INT64_MAX ? -1 : scheduler->deadline - now);
+		now = scheduler->now(scheduler);
+	}
+
+	if (driver->dirty.count == 0 && now < scheduler->deadline) {
+		return false;
+	}
+
+	// Keep maximum frame rate, wakes during sleep are handled by this frame
+	while (scheduler->last_frame != INT64_MIN && now < scheduler->last_frame + scheduler->frame_interval) {
+		scheduler->wait(scheduler, scheduler->last_frame + scheduler->frame_interval - now);
+		now = scheduler->now(scheduler);
+	}
+
+	scheduler->last_frame = now;
+	scheduler->deadline = INT64_MAX;
+	return true;
+}
+
+
+/* Lines of buffer view must start at byte boundary */
+static int ngl_buffer_line_granularity(ngl_buffer_t *buf) {
+	const size_t line_bits = buf->stride * ngl_get_color_bits(buf->format);
+	int granularity = 1;
+	while ((granularity * line_bits) & 0x07) {
+		granularity++;
+	}
+	return granularity;
+}
+
+
+/* View of continuous lines of buffer, y must be aligned to line granularity */
+static void ngl_buffer_lines(ngl_buffer_t *buf, int y, int height, ngl_buffer_t *result) {
+	ngl_area_t area = buf->area;
+	area.y = y;
+	area.height = height;
+	if (!ngl_buffer_view(buf, &area, result)) {
+		ngl_buffer_init(result, &area, NULL, buf->format, buf->driver);
+		result->clip.width = 0;
+		result->clip.height = 0;
+	}
+}
+
+
+/* Remove lines covered by opaque areas spanning whole width of clip */
+static void ngl_occlusion_clip(ngl_area_t *occluders, size_t count, ngl_area_t *clip) {
+	bool changed = true;
+	while (changed && clip->height > 0) {
+		changed = false;
+		for (size_t i = 0; i < count && clip->height > 0; ++i) {
+			ngl_area_t *occluder = &occluders[i];
+			if (occluder->x > clip->x || occluder->x + occluder->width < clip->x + clip->width) {
+				continue;
+			}
+			int top = clip->y;
+			int bottom = clip->y + clip->height;
+			if (occluder->y <= top && occluder->y + occluder->height > top) {
+				top = occluder->y + occluder->height;
+			}
+			else if (occluder->y < bottom && occluder->y + occluder->height >= bottom) {
+				bottom = occluder->y;
+			}
+			else {
+				continue;
+			}
+			clip->y = top;
+			clip->height = MAX(bottom - top, 0);
+			changed = true;
+		}
+	}
+}
+
+
+/* Sort widgets by top edge, order from previous frame is reused so that sorting is usually linear */
+static bool ngl_sweep_begin(ngl_sweep_t *sweep, ngl_widget_t **widgets, size_t count) {
+	if (count > sweep->capacity) {
+		if (sweep->static_storage) {
+			return false;
+		}
+		size_t *order = (size_t *)realloc(sweep->order, count * sizeof(size_t));
+		if (order == NULL) {
+			return false;
+		}
+		sweep->order = order;
+		size_t *active = (size_t *)realloc(sweep->active, count * sizeof(size_t));
+		if (active == NULL) {
+			return false;
+		}
+		sweep->active = active;
+		ngl_area_t *clips = (ngl_area_t *)realloc(sweep->clips, count * sizeof(ngl_area_t));
+		if (clips == NULL) {
+			return false;
+		}
+		sweep->clips = clips;
+		ngl_area_t *occluders = (ngl_area_t *)realloc(sweep->occluders, count * sizeof(ngl_area_t));
+		if (occluders == NULL) {
+			return false;
+		}
+		sweep->occluders = occluders;
+		sweep->capacity = count;
+		sweep->count = 0;
+	}
+
+	if (sweep->count != count) {
+		for (size_t i = 0; i < count; ++i) {
+			sweep->order[i] = i;
+		}
+		sweep->count = count;
+	}
+
+	for (size_t i = 1; i < count; ++i) {
+		const size_t index = sweep->order[i];
+		const int y = widgets[index]->bounds.y;
+		size_t pos = i;
+		while (pos > 0 && widgets[sweep->order[pos - 1]]->bounds.y > y) {
+			sweep->order[pos] = sweep->order[pos - 1];
+			pos--;
+		}
+		sweep->order[pos] = index;
+	}
+
+	sweep->next = 0;
+	sweep->active_count = 0;
+	return true;
+}
+
+
+/* Send draw event to widgets intersecting buffer, buffers must be requested from top to bottom */
+static void ngl_sweep_draw(ngl_driver_t *driver, ngl_sweep_t *sweep, ngl_widget_t **widgets, ngl_buffer_t *buf) {
+	const int top = buf->area.y;
+	const int bottom = buf->area.y + buf->area.height;
+
+	// Drop widgets above band
+	size_t kept = 0;
+	for (size_t i = 0; i < sweep->active_count; ++i) {
+		ngl_area_t *area = &widgets[sweep->active[i]]->bounds;
+		if (area->y + area->height > top) {
+			sweep->active[kept++] = sweep->active[i];
+		}
+	}
+	sweep->active_count = kept;
+
+	// Activate widgets starting above bottom of band, active list keeps drawing order
+	while (sweep->next < sweep->count) {
+		const size_t index = sweep->order[sweep->next];
+		ngl_area_t *area = &widgets[index]->bounds;
+		if (area->y >= bottom) {
+			break;
+		}
+		sweep->next++;
+		if (area->y + area->height <= top || area->width <= 0) {
+			continue;
+		}
+		size_t pos = sweep->active_count;
+		while (pos > 0 && sweep->active[pos - 1] > index) {
+			sweep->active[pos] = sweep->active[pos - 1];
+			pos--;
+		}
+		sweep->active[pos] = index;
+		sweep->active_count++;
+	}
+
+	// Visible lines of widgets, opaque widgets hide everything below them
+	size_t occluder_count = 0;
+	for (size_t i = sweep->active_count; i-- > 0;) {
+		ngl_widget_t *widget = widgets[sweep->active[i]];
+		ngl_area_t *clip = &sweep->clips[i];
+		if (!ngl_area_intersection(&widget->bounds, &buf->area, clip)) {
+			clip->height = 0;
+			continue;
+		}
+		ngl_area_t covered;
+		const bool opaque = (widget->flags & NGL_WIDGET_OPAQUE) && ngl_area_intersection(&widget->area, &buf->area, &covered);
+		ngl_occlusion_clip(sweep->occluders, occluder_count, clip);
+		if (clip->height > 0 && opaque) {
+			sweep->occluders[occluder_count++] = covered;
+		}
+	}
+
+	const int granularity = ngl_buffer_line_granularity(buf);
+	for (size_t i = 0; i < sweep->active_count; ++i) {
+		ngl_widget_t *widget = widgets[sweep->active[i]];
+		ngl_area_t *clip = &sweep->clips[i];
+		if (clip->height <= 0) {
+			continue;
+		}
+		if (clip->y == top && clip->height == buf->area.height) {
+			ngl_draw_tree(driver, widget, buf);
+		}
+		else {
+			// Partially hidden widget draws only to visible lines
+			const int y = top + ((clip->y - top) / granularity) * granularity;
+			ngl_buffer_t view;
+			ngl_buffer_lines(buf, y, clip->y + clip->height - y, &view);
+			ngl_draw_tree(driver, widget, &view);
+		}
+	}
+}
+
 
-	ngl_area_t visible_area = {
-		.x = MAX(target->area.x, area->x),
-		.y = MAX(target->area.y, area->y)
+static void ngl_sweep_rewind(ngl_sweep_t *sweep) {
+	sweep->next = 0;
+	sweep->active_count = 0;
+}
+
+
+typedef struct ngl_tile_job {
+	ngl_display_list_t *list;
+	ngl_buffer_t *band;
+	int tile_height;
+} ngl_tile_job_t;
+
+
+static void ngl_draw_tile(void *arg, size_t index) {
+	ngl_tile_job_t *job = (ngl_tile_job_t *)arg;
+	ngl_buffer_t *band = job->band;
+	const int offset = index * job->tile_height;
+
+	// Lines are continuous, tile is part of band buffer
+	ngl_buffer_t tile;
+	NGL_PROFILE_BEGIN(band->driver, span);
+	ngl_buffer_lines(band, band->area.y + offset, MIN(job->tile_height, band->area.height - offset), &tile);
+	ngl_display_list_replay(job->list, &tile);
+	NGL_PROFILE_END(band->driver, span, NGL_PROFILE_TILE, NULL, index);
+}
+
+
+/* Split band to tiles of whole lines and replay them concurrently
+ *
+ * Every tile writes only own lines and replays commands in recorded order,
+ * so result is same as replay of whole band.
+ */
+static void ngl_draw_tiles(ngl_executor_t *executor, ngl_display_list_t *list, ngl_buffer_t *buf) {
+	const int granularity = ngl_buffer_line_granularity(buf);
+
+	// More tiles than workers balance uneven content
+	const int tile_count = executor->workers * 2;
+	int tile_height = (buf->area.height + tile_count - 1) / tile_count;
+	tile_height = ((tile_height + granularity - 1) / granularity) * granularity;
+
+	ngl_tile_job_t job = {
+		.list = list,
+		.band = buf,
+		.tile_height = tile_height,
 	};
-	visible_area.width = MIN(target->area.x + target->area.width, area->x + area->width) - visible_area.x;
-	visible_area.height = MIN(target->area.y + target->area.height, area->y + area->height) - visible_area.y;
+	executor->run(executor, ngl_draw_tile, &job, (buf->area.height + tile_height - 1) / tile_height);
+}
+
+
+static void ngl_draw_buffer(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count, ngl_buffer_t *buf, bool sweep, ngl_display_list_t *list) {
+	if (list != NULL) {
+		if (driver->executor != NULL && driver->executor->workers > 1 && buf->area.height > 1) {
+			ngl_draw_tiles(driver->executor, list, buf);
+		}
+		else {
+			ngl_display_list_replay(list, buf);
+		}
+	}
+	else if (sweep) {
+		ngl_sweep_draw(driver, &driver->sweep, widgets, buf);
+	}
+	else {
+		ngl_send_events(driver, widgets, count, NGL_EVENT_DRAW, buf);
+	}
+}
+
+
+/* Record draw commands of widgets in area, returns false if they don't fit to display list */
+static bool ngl_draw_record(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count, ngl_area_t *area, bool sweep) {
+	ngl_display_list_t *list = driver->display_list;
+	list->count = 0;
+	list->overflow = false;
 
-	ngl_color_t *buffer = (ngl_color_t *)target->buffer;
-	size_t target_pos = visible_area.x - target->area.x + (visible_area.y - target->area.y) * target->area.width;
-	size_t target_skip = target->area.width - visible_area.width;
-	size_t target_end_pos = target_pos + visible_area.width + (visible_area.height - 1) * target->area.width;
+	NGL_PROFILE_BEGIN(driver, span);
+	ngl_buffer_t recorder;
+	ngl_buffer_init(&recorder, area, NULL, driver->format, driver);
+	recorder.recorder = list;
+	ngl_draw_buffer(driver, widgets, count, &recorder, sweep, NULL);
+	NGL_PROFILE_END(driver, span, NGL_PROFILE_RECORD, NULL, list->count);
 
-	size_t x_pos = 0;
+	return !list->overflow;
+}
+
+
+void ngl_draw_frame(ngl_driver_t *driver, ngl_widget_t **widgets, size_t count) {
+	NGL_PROFILE_BEGIN(driver, frame_span);
+	driver->frame++;
+	driver->stats.frames++;
+
+	ngl_animations_update(driver);
+	ngl_send_events(driver, widgets, count, NGL_EVENT_FRAME_START, NULL);
 
-	while (target_pos < target_end_pos) {
-		buffer[target_pos].value = color.value;
-		x_pos++;
-		target_pos++;
-		if (x_pos == visible_area.width) {
-			target_pos += target_skip;
-			x_pos = 0;
+	// Drivers without windows redraw whole screen
+	if (driver->get_window == NULL) {
+		ngl_invalidate(driver);
+	}
+	ngl_dirty_region_t dirty = driver->dirty;
+	driver->dirty.count = 0;
+
+	// Without memory for sorting all widgets are drawn to every band
+	const bool sweep = ngl_sweep_begin(&driver->sweep, widgets, count);
+
+	ngl_display_list_t *list = NULL;
+	if (driver->display_list != NULL && dirty.count > 0) {
+		ngl_area_t frame_area = dirty.areas[0];
+		for (size_t i = 1; i < dirty.count; ++i) {
+			ngl_area_union(&frame_area, &dirty.areas[i], &frame_area);
+		}
+		if (ngl_draw_record(driver, widgets, count, &frame_area, sweep)) {
+			list = driver->display_list;
+		}
+		ngl_sweep_rewind(&driver->sweep);
+	}
+
+	ngl_buffer_t *buf;
+	if (driver->get_window == NULL) {
+		do {
+			NGL_PROFILE_BEGIN(driver, band_span);
+			buf = ngl_get_buffer(driver);
+			ngl_draw_buffer(driver, widgets, count, buf, sweep, list);
+			ngl_flush(driver);
+			NGL_PROFILE_END(driver, band_span, NGL_PROFILE_BAND, NULL, buf->area.y);
+		} while (buf->area.y + buf->area.height < driver->height);
+	}
+	else {
+		int y = 0;
+		int lines = 0;
+		ngl_area_t window;
+		while (ngl_dirty_next_window(&dirty, y, &window)) {
+			NGL_PROFILE_BEGIN(driver, band_span);
+			buf = ngl_get_window(driver, &window);
+			ngl_draw_buffer(driver, widgets, count, buf, sweep, list);
+			ngl_flush(driver);
+			NGL_PROFILE_END(driver, band_span, NGL_PROFILE_BAND, NULL, buf->area.y);
+			y = buf->area.y + buf->area.height;
+			lines += buf->area.height;
 		}
+		driver->stats.lines_skipped += driver->height - lines;
+		if (lines == 0) {
+			driver->stats.frames_skipped++;
+		}
+	}
+
+	if (driver->end_frame != NULL) {
+		driver->end_frame(driver);
+	}
+
+	ngl_send_events(driver, widgets, count, NGL_EVENT_FRAME_END, NULL);
+
+	if (driver->arena != NULL) {
+		ngl_frame_arena_reset(driver->arena);
 	}
+	NGL_PROFILE_END(driver, frame_span, NGL_PROFILE_FRAME, NULL, driver->frame);
 }
 
 
+#include "animation/timeline.c"
+#include "draw/display_list.c"
+#include "draw/fill.c"
+#include "draw/pixmap.c"
+#include "memory/frame_arena.c"
+#include "profile/profiler.c"
+#include "widgets/batch.c"
+#include "widgets/cache.c"
 #include "widgets/rectangle.c"
@@ -0,0 +1,312 @@
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#else
+#include <time.h>
+#endif
+
+#include "nanogl.h"
+#include "nanogl/profile.h"
+
+
+static const char *ngl_profile_kind_names[NGL_PROFILE_KIND_COUNT] = {
+	"frame",
+	"event",
+	"record",
+	"band",
+	"tile",
+	"get_buffer",
+	"flush",
+	"convert",
+	"queue_wait",
+};
+
+
+static const char *ngl_profile_event_name(int32_t event) {
+	switch (event) {
+		case NGL_EVENT_DRAW: return "draw";
+		case NGL_EVENT_INIT: return "init";
+		case NGL_EVENT_DESTROY: return "destroy";
+		case NGL_EVENT_RESHAPE: return "reshape";
+		case NGL_EVENT_FRAME_START: return "frame_start";
+		case NGL_EVENT_FRAME_END: return "frame_end";
+		default: return "user";
+	}
+}
+
+
+static int64_t ngl_profile_now(void) {
+#ifdef ESP_PLATFORM
+	return esp_timer_get_time() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+
+static uint16_t ngl_profile_thread(void) {
+#ifdef ESP_PLATFORM
+	return xPortGetCoreID();
+#else
+	static _Thread_local int thread = -1;
+	static int thread_count = 0;
+	if (thread < 0) {
+		thread = __atomic_fetch_add(&thread_count, 1, __ATOMIC_RELAXED);
+	}
+	return thread;
+#endif
+}
+
+
+void ngl_profiler_init(ngl_profiler_t *profiler, ngl_profile_record_t *records, size_t capacity) {
+	assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+	profiler->records = records;
+	profiler->capacity = capacity;
+	profiler->head = 0;
+	profiler->enabled = true;
+	profiler->label_count = 0;
+}
+
+
+void ngl_profiler_clear(ngl_profiler_t *profiler) {
+	__atomic_store_n(&profiler->head, 0, __ATOMIC_RELEASE);
+}
+
+
+void ngl_profiler_label(ngl_profiler_t *profiler, const void *subject, const char *name) {
+	for (size_t i = 0; i < profiler->label_count; ++i) {
+		if (profiler->labels[i].subject == subject) {
+			profiler->labels[i].name = name;
+			return;
+		}
+	}
+	if (profiler->label_count < NGL_PROFILE_LABELS_MAX) {
+		profiler->labels[profiler->label_count].subject = subject;
+		profiler->labels[profiler->label_count].name = name;
+		profiler->label_count++;
+	}
+}
+
+
+int64_t ngl_profile_begin(ngl_driver_t *driver) {
+	ngl_profiler_t *profiler = driver->profiler;
+	if (profiler == NULL || !__atomic_load_n(&profiler->enabled, __ATOMIC_RELAXED)) {
+		return 0;
+	}
+	return ngl_profile_now();
+}
+
+
+void ngl_profile_end(ngl_driver_t *driver, int64_t start, ngl_profile_kind_t kind, const void *subject, int32_t value) {
+	ngl_profiler_t *profiler = driver->profiler;
+	if (start == 0 || profiler == NULL) {
+		return;
+	}
+	const int64_t end = ngl_profile_now();
+
+	// Every writer owns reserved slot, nothing else is shared
+	const size_t index = __atomic_fetch_add(&profiler->head, 1, __ATOMIC_RELAXED) & (profiler->capacity - 1);
+	ngl_profile_record_t *record = &profiler->records[index];
+	record->start = start;
+	record->duration = end - start > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - start);
+	record->kind = kind;
+	record->thread = ngl_profile_thread();
+	record->subject = subject;
+	record->value = value;
+}
+
+
+/* Range of valid records, oldest first */
+static size_t ngl_profiler_range(ngl_profiler_t *profiler, size_t *first) {
+	const size_t head = __atomic_load_n(&profiler->head, __ATOMIC_ACQUIRE);
+	const size_t count = MIN(head, profiler->capacity);
+	*first = head - count;
+	return count;
+}
+
+
+static const char *ngl_profiler_find_label(ngl_profiler_t *profiler, const void *subject) {
+	for (size_t i = 0; i < profiler->label_count; ++i) {
+		if (profiler->labels[i].subject == subject) {
+			return profiler->labels[i].name;
+		}
+	}
+	return NULL;
+}
+
+
+/* Name of subject, label or address */
+static void ngl_profiler_subject_name(ngl_profiler_t *profiler, const void *subject, char *name, size_t size) {
+	const char *label = ngl_profiler_find_label(profiler, subject);
+	if (label != NULL) {
+		snprintf(name, size, "%s", label);
+	}
+	else if (subject != NULL) {
+		snprintf(name, size, "%p", subject);
+	}
+	else {
+		name[0] = '\0';
+	}
+}
+
+
+static void ngl_profiler_write_string(FILE *out, const char *text) {
+	fputc('"', out);
+	for (; *text != '\0'; ++text) {
+		if (*text == '"' || *text == '\\') {
+			fputc('\\', out);
+		}
+		if ((unsigned char)*text >= 0x20) {
+			fputc(*text, out);
+		}
+	}
+	fputc('"', out);
+}
+
+
+void ngl_profiler_write_trace(ngl_profiler_t *profiler, FILE *out) {
+	size_t first;
+	const size_t count = ngl_profiler_range(profiler, &first);
+
+	// Times are relative to oldest span
+	int64_t origin = INT64_MAX;
+	for (size_t i = 0; i < count; ++i) {
+		origin = MIN(origin, profiler->records[(first + i) & (profiler->capacity - 1)].start);
+	}
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < count; ++i) {
+		const ngl_profile_record_t *record = &profiler->records[(first + i) & (profiler->capacity - 1)];
+		char subject[32];
+		char name[48];
+		ngl_profiler_subject_name(profiler, record->subject, subject, sizeof(subject));
+		if (record->kind == NGL_PROFILE_EVENT) {
+			snprintf(name, sizeof(name), "%s %s", subject, ngl_profile_event_name(record->value));
+		}
+		else {
+			snprintf(name, sizeof(name), "%s", record->kind < NGL_PROFILE_KIND_COUNT ? ngl_profile_kind_names[record->kind] : "unknown");
+		}
+
+		fprintf(out, "{\"name\":");
+		ngl_profiler_write_string(out, name);
+		fprintf(
+			out,
+			",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"value\":%ld,\"subject\":",
+			record->kind < NGL_PROFILE_KIND_COUNT ? ngl_profile_kind_names[record->kind] : "unknown",
+			record->thread,
+			(record->start - origin) / 1000.0,
+			record->duration / 1000.0,
+			(long)record->value
+		);
+		ngl_profiler_write_string(out, subject);
+		fprintf(out, "}}%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(out, "]}\n");
+}
+
+
+typedef struct ngl_profile_summary_row {
+	uint16_t kind;
+	const void *subject;
+	int32_t event;
+	size_t count;
+	uint64_t total;
+	uint32_t max;
+} ngl_profile_summary_row_t;
+
+
+static void ngl_profiler_write_rows(ngl_profiler_t *profiler, FILE *out, ngl_profile_summary_row_t *rows, size_t count) {
+	// Most expensive first
+	for (size_t i = 1; i < count; ++i) {
+		ngl_profile_summary_row_t row = rows[i];
+		size_t pos = i;
+		while (pos > 0 && rows[pos - 1].total < row.total) {
+			rows[pos] = rows[pos - 1];
+			pos--;
+		}
+		rows[pos] = row;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		char subject[32];
+		ngl_profiler_subject_name(profiler, rows[i].subject, subject, sizeof(subject));
+		if (rows[i].kind == NGL_PROFILE_EVENT) {
+			const size_t length = strlen(subject);
+			snprintf(subject + length, sizeof(subject) - length, "%s%s", length ? " " : "all ", ngl_profile_event_name(rows[i].event));
+		}
+		fprintf(
+			out,
+			"%-12s %-28s %8zu %10.1f %9.2f %9.2f\n",
+			ngl_profile_kind_names[rows[i].kind],
+			subject,
+			rows[i].count,
+			rows[i].total / 1000.0,
+			rows[i].total / 1000.0 / rows[i].count,
+			rows[i].max / 1000.0
+		);
+	}
+}
+
+
+void ngl_profiler_write_summary(ngl_profiler_t *profiler, FILE *out) {
+	// Drawing stages have own rows, widget events share rest of table
+	ngl_profile_summary_row_t stages[NGL_PROFILE_KIND_COUNT];
+	ngl_profile_summary_row_t widgets[NGL_PROFILE_SUMMARY_MAX];
+	size_t widget_count = 0;
+	size_t dropped = 0;
+	for (size_t i = 0; i < NGL_PROFILE_KIND_COUNT; ++i) {
+		stages[i] = (ngl_profile_summary_row_t){.kind = i};
+	}
+
+	size_t first;
+	const size_t count = ngl_profiler_range(profiler, &first);
+	for (size_t i = 0; i < count; ++i) {
+		const ngl_profile_record_t *record = &profiler->records[(first + i) & (profiler->capacity - 1)];
+		ngl_profile_summary_row_t *row = NULL;
+		if (record->kind >= NGL_PROFILE_KIND_COUNT) {
+			continue;
+		}
+		if (record->kind != NGL_PROFILE_EVENT) {
+			row = &stages[record->kind];
+		}
+		else {
+			// Drawing is measured per widget, other events only per type
+			const void *subject = record->value == NGL_EVENT_DRAW ? record->subject : NULL;
+			size_t index = 0;
+			while (index < widget_count && (widgets[index].subject != subject || widgets[index].event != record->value)) {
+				index++;
+			}
+			if (index == widget_count) {
+				if (widget_count == NGL_PROFILE_SUMMARY_MAX) {
+					dropped++;
+					continue;
+				}
+				widgets[index] = (ngl_profile_summary_row_t){.kind = NGL_PROFILE_EVENT, .subject = subject, .event = record->value};
+				widget_count++;
+			}
+			row = &widgets[index];
+		}
+		row->count++;
+		row->total += record->duration;
+		row->max = MAX(row->max, record->duration);
+	}
+
+	// Stages without spans are skipped
+	size_t stage_count = 0;
+	for (size_t i = 0; i < NGL_PROFILE_KIND_COUNT; ++i) {
+		if (stages[i].count > 0 && i != NGL_PROFILE_EVENT) {
+			stages[stage_count++] = stages[i];
+		}
+	}
+
+	fprintf(out, "%-12s %-28s %8s %10s %9s %9s\n", "kind", "subject", "count", "total_us", "mean_us", "max_us");
+	ngl_profiler_write_rows(profiler, out, stages, stage_count);
+	ngl_profiler_write_rows(profiler, out, widgets, widget_count);
+	if (dropped > 0) {
+		fprintf(out, "%zu spans of other widgets not summarized\n", dropped);
+	}
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#endif
+
+#include "nanogl/scheduler_freertos.h"
+
+
+/* Semaphore instead of task notification, drawing task can wait for notifications from drivers */
+static bool ngl_freertos_scheduler_wait(ngl_scheduler_t *scheduler, int64_t timeout_us) {
+	SemaphoreHandle_t semaphore = (SemaphoreHandle_t)scheduler->priv;
+	TickType_t ticks = portMAX_DELAY;
+	if (timeout_us >= 0) {
+		// Round up, zero ticks would not sleep
+		ticks = (timeout_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+	}
+	return xSemaphoreTake(semaphore, ticks) == pdTRUE;
+}
+
+
+static void ngl_freertos_scheduler_wake(ngl_scheduler_t *scheduler) {
+	xSemaphoreGive((SemaphoreHandle_t)scheduler->priv);
+}
+
+
+static int64_t ngl_freertos_scheduler_now(ngl_scheduler_t *scheduler) {
+#ifdef ESP_PLATFORM
+	return esp_timer_get_time();
+#else
+	return (int64_t)xTaskGetTickCount() * portTICK_PERIOD_MS * 1000;
+#endif
+}
+
+
+static void ngl_freertos_scheduler_setup(ngl_scheduler_t *scheduler, int max_fps) {
+	ngl_scheduler_init(scheduler, max_fps);
+	scheduler->wait = ngl_freertos_scheduler_wait;
+	scheduler->wake = ngl_freertos_scheduler_wake;
+	scheduler->now = ngl_freertos_scheduler_now;
+}
+
+
+bool ngl_freertos_scheduler_init(ngl_scheduler_t *scheduler, int max_fps) {
+	ngl_freertos_scheduler_setup(scheduler, max_fps);
+	scheduler->priv = xSemaphoreCreateBinary();
+	return scheduler->priv != NULL;
+}
+
+
+bool ngl_freertos_scheduler_init_static(ngl_scheduler_t *scheduler, int max_fps, void *storage, size_t storage_size) {
+	ngl_freertos_scheduler_setup(scheduler, max_fps);
+	scheduler->priv = NULL;
+	if (storage == NULL || storage_size < NGL_FREERTOS_SCHEDULER_STORAGE_SIZE) {
+		return false;
+	}
+	StaticSemaphore_t *semaphore_buffer = (StaticSemaphore_t *)NGL_STORAGE_ROUND((uintptr_t)storage);
+	scheduler->priv = xSemaphoreCreateBinaryStatic(semaphore_buffer);
+	return scheduler->priv != NULL;
+}
+
+
+void ngl_freertos_scheduler_destroy(ngl_scheduler_t *scheduler) {
+	// Static semaphore is only unregistered, storage stays with caller
+	if (scheduler->priv != NULL) {
+		vSemaphoreDelete((SemaphoreHandle_t)scheduler->priv);
+		scheduler->priv = NULL;
+	}
+}
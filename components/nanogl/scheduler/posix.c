@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "nanogl/scheduler_posix.h"
+
+
+typedef struct ngl_posix_scheduler_priv {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool woken;
+} ngl_posix_scheduler_priv_t;
+
+
+static int64_t ngl_posix_scheduler_now(ngl_scheduler_t *scheduler) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+static bool ngl_posix_scheduler_wait(ngl_scheduler_t *scheduler, int64_t timeout_us) {
+	ngl_posix_scheduler_priv_t *priv = (ngl_posix_scheduler_priv_t *)scheduler->priv;
+
+	struct timespec deadline;
+	if (timeout_us >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		const int64_t nsec = deadline.tv_nsec + (timeout_us % 1000000) * 1000;
+		deadline.tv_sec += timeout_us / 1000000 + nsec / 1000000000;
+		deadline.tv_nsec = nsec % 1000000000;
+	}
+
+	pthread_mutex_lock(&priv->mutex);
+	int status = 0;
+	while (!priv->woken && status == 0) {
+		if (timeout_us >= 0) {
+			status = pthread_cond_timedwait(&priv->cond, &priv->mutex, &deadline);
+		}
+		else {
+			status = pthread_cond_wait(&priv->cond, &priv->mutex);
+		}
+	}
+	const bool woken = priv->woken;
+	priv->woken = false;
+	pthread_mutex_unlock(&priv->mutex);
+	return woken;
+}
+
+
+static void ngl_posix_scheduler_wake(ngl_scheduler_t *scheduler) {
+	ngl_posix_scheduler_priv_t *priv = (ngl_posix_scheduler_priv_t *)scheduler->priv;
+	pthread_mutex_lock(&priv->mutex);
+	priv->woken = true;
+	pthread_cond_signal(&priv->cond);
+	pthread_mutex_unlock(&priv->mutex);
+}
+
+
+bool ngl_posix_scheduler_init(ngl_scheduler_t *scheduler, int max_fps) {
+	ngl_scheduler_init(scheduler, max_fps);
+	scheduler->wait = ngl_posix_scheduler_wait;
+	scheduler->wake = ngl_posix_scheduler_wake;
+	scheduler->now = ngl_posix_scheduler_now;
+
+	ngl_posix_scheduler_priv_t *priv = (ngl_posix_scheduler_priv_t *)malloc(sizeof(ngl_posix_scheduler_priv_t));
+	scheduler->priv = priv;
+	if (priv == NULL) {
+		return false;
+	}
+	priv->woken = false;
+	pthread_mutex_init(&priv->mutex, NULL);
+	// Timeouts use monotonic clock
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&priv->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	return true;
+}
+
+
+void ngl_posix_scheduler_destroy(ngl_scheduler_t *scheduler) {
+	ngl_posix_scheduler_priv_t *priv = (ngl_posix_scheduler_priv_t *)scheduler->priv;
+	if (priv != NULL) {
+		pthread_cond_destroy(&priv->cond);
+		pthread_mutex_destroy(&priv->mutex);
+		free(priv);
+		scheduler->priv = NULL;
+	}
+}
@@ -0,0 +1,107 @@
+#include <string.h>
+
+#include "nanogl.h"
+#include "nanogl/batch.h"
+
+
+/* Extend bounds of batch widget by instance area */
+static void ngl_batch_grow(ngl_widget_t *widget, ngl_area_t *area) {
+	if (area->width <= 0 || area->height <= 0) {
+		return;
+	}
+	if (widget->area.width <= 0 || widget->area.height <= 0) {
+		widget->area = *area;
+	}
+	else {
+		ngl_area_union(&widget->area, area, &widget->area);
+	}
+	ngl_widget_update_bounds(widget);
+}
+
+
+void ngl_batch_init(ngl_driver_t *driver, ngl_widget_t *widget, ngl_batch_t *batch, ngl_batch_draw_fn draw, ngl_area_t *areas, void *state, size_t state_size, size_t capacity) {
+	batch->draw = draw;
+	batch->areas = areas;
+	batch->state = state;
+	batch->state_size = state_size;
+	batch->count = 0;
+	batch->capacity = capacity;
+	batch->bounds_dirty = false;
+	ngl_widget_init(driver, widget, ngl_widget_batch, &((ngl_area_t){0, 0, 0, 0}), batch, NULL);
+}
+
+
+int ngl_batch_add(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t *area) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	if (batch->count == batch->capacity) {
+		return -1;
+	}
+	const size_t index = batch->count++;
+	batch->areas[index] = *area;
+	ngl_batch_grow(widget, area);
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, area);
+	return index;
+}
+
+
+void ngl_batch_remove(ngl_driver_t *driver, ngl_widget_t *widget, size_t index) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &batch->areas[index]);
+	const size_t last = --batch->count;
+	if (index != last) {
+		batch->areas[index] = batch->areas[last];
+		memcpy((ngl_byte_t *)batch->state + index * batch->state_size, (ngl_byte_t *)batch->state + last * batch->state_size, batch->state_size);
+	}
+	batch->bounds_dirty = true;
+}
+
+
+void ngl_batch_set_area(ngl_driver_t *driver, ngl_widget_t *widget, size_t index, ngl_area_t *area) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &batch->areas[index]);
+	batch->areas[index] = *area;
+	ngl_invalidate_area(driver, area);
+	ngl_batch_grow(widget, area);
+	batch->bounds_dirty = true;
+}
+
+
+void ngl_batch_invalidate(ngl_driver_t *driver, ngl_widget_t *widget, size_t index) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	ngl_widget_invalidate_caches(widget);
+	ngl_invalidate_area(driver, &batch->areas[index]);
+}
+
+
+static void ngl_widget_batch_frame_start(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	if (!batch->bounds_dirty) {
+		return;
+	}
+	// Shrink bounds, instances invalidated own areas already
+	batch->bounds_dirty = false;
+	widget->area.width = 0;
+	widget->area.height = 0;
+	for (size_t i = 0; i < batch->count; ++i) {
+		ngl_batch_grow(widget, &batch->areas[i]);
+	}
+	ngl_widget_update_bounds(widget);
+}
+
+
+static void ngl_widget_batch_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	ngl_batch_t *batch = (ngl_batch_t *)widget->priv;
+	batch->draw(driver, batch, buffer);
+}
+
+
+void ngl_widget_batch(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
+	static ngl_widget_event_table_t event_table = {
+		.frame_start = ngl_widget_batch_frame_start,
+		.draw = ngl_widget_batch_draw
+	};
+	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
+}
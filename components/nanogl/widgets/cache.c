@@ -0,0 +1,211 @@
+#include <string.h>
+
+#include "nanogl.h"
+#include "nanogl/cache.h"
+
+
+void ngl_surface_cache_init(ngl_surface_cache_t *cache, size_t budget, uint32_t caps) {
+	cache->caps = caps;
+	cache->budget = budget;
+	cache->used = 0;
+	cache->first = NULL;
+	cache->last = NULL;
+}
+
+
+static void ngl_surface_cache_unlink(ngl_surface_cache_t *cache, ngl_widget_cache_t *cached) {
+	if (cached->prev != NULL) {
+		cached->prev->next = cached->next;
+	}
+	else {
+		cache->first = cached->next;
+	}
+	if (cached->next != NULL) {
+		cached->next->prev = cached->prev;
+	}
+	else {
+		cache->last = cached->prev;
+	}
+	cached->prev = NULL;
+	cached->next = NULL;
+}
+
+
+static void ngl_surface_cache_push(ngl_surface_cache_t *cache, ngl_widget_cache_t *cached) {
+	cached->prev = NULL;
+	cached->next = cache->first;
+	if (cache->first != NULL) {
+		cache->first->prev = cached;
+	}
+	else {
+		cache->last = cached;
+	}
+	cache->first = cached;
+}
+
+
+static void ngl_widget_cache_release(ngl_widget_cache_t *cached) {
+	if (cached->surface.buffer == NULL) {
+		return;
+	}
+	ngl_surface_cache_t *cache = cached->cache;
+	ngl_surface_cache_unlink(cache, cached);
+	ngl_free(cached->surface.buffer);
+	cached->surface.buffer = NULL;
+	cache->used -= cached->size;
+	cached->size = 0;
+	cached->stale = true;
+}
+
+
+void ngl_surface_cache_destroy(ngl_surface_cache_t *cache) {
+	while (cache->first != NULL) {
+		ngl_widget_cache_release(cache->first);
+	}
+}
+
+
+/* Release least recently used surfaces not drawn in current frame until size fits to budget */
+static bool ngl_surface_cache_reserve(ngl_surface_cache_t *cache, size_t size, uint64_t frame) {
+	if (size > cache->budget) {
+		return false;
+	}
+	while (cache->used + size > cache->budget) {
+		ngl_widget_cache_t *victim = cache->last;
+		if (victim == NULL || victim->frame == frame) {
+			return false;
+		}
+		ngl_widget_cache_release(victim);
+	}
+	return true;
+}
+
+
+/* Called when widget or its descendant is invalidated */
+static void ngl_widget_invalidate_caches(ngl_widget_t *widget) {
+	for (; widget != NULL; widget = widget->parent) {
+		if (widget->flags & NGL_WIDGET_CACHED) {
+			((ngl_widget_cache_t *)widget->priv)->stale = true;
+		}
+	}
+}
+
+
+static void ngl_widget_cache_draw_children(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	for (size_t i = 0; i < widget->child_count; ++i) {
+		ngl_widget_t *child = widget->children[i];
+		if (ngl_area_intersects(&child->bounds, &buffer->clip)) {
+			ngl_draw_tree(driver, child, buffer);
+		}
+	}
+}
+
+
+/* Allocate and render surface if needed, returns false if it doesn't fit to memory */
+static bool ngl_widget_cache_prepare(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_widget_cache_t *cached = (ngl_widget_cache_t *)widget->priv;
+	ngl_surface_cache_t *cache = cached->cache;
+
+	if (cached->surface.buffer == NULL) {
+		const size_t size = ((size_t)widget->area.width * widget->area.height * ngl_get_color_bits(cached->format) + 7) >> 3;
+		if (!ngl_surface_cache_reserve(cache, size, driver->frame)) {
+			return false;
+		}
+		ngl_byte_t *data = (ngl_byte_t *)ngl_alloc(size, cache->caps);
+		if (data == NULL) {
+			return false;
+		}
+		ngl_buffer_init(&cached->surface, &widget->area, data, cached->format, driver);
+		cached->size = size;
+		cached->stale = true;
+		cache->used += size;
+	}
+	else {
+		ngl_surface_cache_unlink(cache, cached);
+	}
+	ngl_surface_cache_push(cache, cached);
+	cached->frame = driver->frame;
+
+	if (cached->stale) {
+		cached->stale = false;
+		memset(cached->surface.buffer, 0, cached->size);
+		ngl_widget_cache_draw_children(driver, widget, &cached->surface);
+	}
+	return true;
+}
+
+
+void ngl_widget_cache_init(ngl_driver_t *driver, ngl_widget_t *widget, ngl_widget_cache_t *cached, ngl_surface_cache_t *cache, ngl_color_format_t format, ngl_area_t *area) {
+	cached->cache = cache;
+	cached->format = format;
+	ngl_buffer_init(&cached->surface, area, NULL, format, driver);
+	cached->size = 0;
+	cached->stale = true;
+	cached->frame = 0;
+	cached->prev = NULL;
+	cached->next = NULL;
+	ngl_widget_init(driver, widget, ngl_widget_cache, area, cached, NULL);
+	widget->flags |= NGL_WIDGET_CACHED;
+}
+
+
+static void ngl_widget_cache_destroy(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_widget_cache_release((ngl_widget_cache_t *)widget->priv);
+}
+
+
+static void ngl_widget_cache_reshape(ngl_driver_t *driver, ngl_widget_t *widget, ngl_area_t *area) {
+	ngl_widget_cache_t *cached = (ngl_widget_cache_t *)widget->priv;
+	cached->stale = true;
+	if (cached->surface.buffer == NULL) {
+		return;
+	}
+	// Moved surface keeps memory
+	if (cached->surface.area.width != area->width || cached->surface.area.height != area->height) {
+		ngl_widget_cache_release(cached);
+		return;
+	}
+	ngl_buffer_init(&cached->surface, area, cached->surface.buffer, cached->format, driver);
+}
+
+
+static void ngl_widget_cache_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
+	ngl_widget_cache_t *cached = (ngl_widget_cache_t *)widget->priv;
+	if (widget->area.width <= 0 || widget->area.height <= 0) {
+		return;
+	}
+
+	// Direct drawing visits widget in every band, statistics count it once per frame
+	const bool counted = cached->frame == driver->frame;
+	const bool hit = cached->surface.buffer != NULL && !cached->stale;
+	const bool prepared = ngl_widget_cache_prepare(driver, widget);
+	if (!counted) {
+		if (prepared && hit) {
+			driver->stats.cache_hits++;
+		}
+		else {
+			driver->stats.cache_misses++;
+		}
+	}
+	cached->frame = driver->frame;
+	if (prepared) {
+		ngl_draw_pixmap(buffer, &cached->surface, NULL, (ngl_color_t){.value = 0xffffffff});
+		return;
+	}
+
+	// Surface doesn't fit, children are drawn directly
+	if (ngl_push_clip(buffer, &widget->area)) {
+		ngl_widget_cache_draw_children(driver, widget, buffer);
+	}
+	ngl_pop_clip(buffer);
+}
+
+
+void ngl_widget_cache(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
+	static ngl_widget_event_table_t event_table = {
+		.destroy = ngl_widget_cache_destroy,
+		.reshape = ngl_widget_cache_reshape,
+		.draw = ngl_widget_cache_draw
+	};
+	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
+}
@@ -1,4 +1,5 @@
 #include "nanogl.h"
+#include "nanogl/batch.h"
 #include "nanogl/rectangle.h"
 
 
@@ -17,6 +18,18 @@ static void ngl_widget_rectangle_init(ngl_driver_t *driver, ngl_widget_t *widget
 }
 
 
+static void ngl_widget_rectangle_frame_start(ngl_driver_t *driver, ngl_widget_t *widget) {
+	ngl_color_t *color = (ngl_widget_rectangle_data_t *)widget->priv;
+	// Color can be changed between frames
+	if (color->rgba.a == 255) {
+		widget->flags |= NGL_WIDGET_OPAQUE;
+	}
+	else {
+		widget->flags &= ~NGL_WIDGET_OPAQUE;
+	}
+}
+
+
 static void ngl_widget_rectangle_draw(ngl_driver_t *driver, ngl_widget_t *widget, ngl_buffer_t *buffer) {
 	ngl_color_t *color = (ngl_widget_rectangle_data_t *)widget->priv;
 	ngl_fill_area(buffer, &widget->area, *color);
@@ -26,7 +39,18 @@ static void ngl_widget_rectangle_draw(ngl_driver_t *driver, ngl_widget_t *widget
 void ngl_widget_rectangle(ngl_driver_t *driver, ngl_widget_t *widget, ngl_event_t event, void *data) {
 	static ngl_widget_event_table_t event_table = {
 		.init = ngl_widget_rectangle_init,
+		.frame_start = ngl_widget_rectangle_frame_start,
 		.draw = ngl_widget_rectangle_draw
 	};
 	ngl_event_table_dispatch(driver, widget, &event_table, event, data);
 }
+
+
+void ngl_widget_rectangle_batch_draw(ngl_driver_t *driver, ngl_batch_t *batch, ngl_buffer_t *buffer) {
+	const ngl_color_t *colors = (const ngl_color_t *)batch->state;
+	for (size_t i = 0; i < batch->count; ++i) {
+		if (ngl_area_intersects(&batch->areas[i], &buffer->clip)) {
+			ngl_fill_area(buffer, &batch->areas[i], colors[i]);
+		}
+	}
+}
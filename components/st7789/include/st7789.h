@@ -6,6 +6,8 @@
 #include "driver/spi_master.h"
 #include "esp_err.h"
 
+#include "st7789_color.h"
+
 
 // System Function Command Table 1
 #define ST7789_CMD_NOP               0x00 // No operation
@@ -93,6 +95,16 @@
 
 #define ST7789_CMDLIST_END           0xff // End command (used for command list)
 
+// Parts of caller provided storage are aligned to this size
+#define ST7789_STORAGE_ALIGN 8
+#define ST7789_STORAGE_ROUND(size) (((size) + ST7789_STORAGE_ALIGN - 1) & ~(size_t)(ST7789_STORAGE_ALIGN - 1))
+
+// Bytes of DMA capable storage for st7789_init_static, buffer_size is in pixels
+#define ST7789_STORAGE_SIZE(buffer_size, buffer_count) (ST7789_STORAGE_ALIGN - 1 + \
+	ST7789_STORAGE_ROUND((buffer_count) * sizeof(spi_transaction_t)) + \
+	ST7789_STORAGE_ROUND((buffer_count) * sizeof(st7789_color_t *)) + \
+	(buffer_count) * ST7789_STORAGE_ROUND((buffer_size) * sizeof(st7789_color_t)))
+
 struct st7789_driver;
 
 typedef struct st7789_transaction_data {
@@ -100,8 +112,6 @@ typedef struct st7789_transaction_data {
 	bool data;
 } st7789_transaction_data_t;
 
-typedef uint16_t st7789_color_t;
-
 typedef struct st7789_driver {
 	int pin_reset;
 	int pin_dc;
@@ -122,8 +132,15 @@ typedef struct st7789_driver {
 	st7789_color_t **framebuffers;
 	spi_transaction_t *transactions;
 	size_t current_buffer_num;
+	// Buffers are in caller storage
+	bool static_storage;
 
 	st7789_color_t *current_buffer;
+
+	// Statistics, counters wrap
+	uint32_t bytes_queued;
+	// Time blocked in st7789_wait_until_queue_free in microseconds
+	uint32_t queue_wait_us;
 } st7789_driver_t;
 
 typedef struct st7789_command {
@@ -134,6 +151,8 @@ typedef struct st7789_command {
 } st7789_command_t;
 
 esp_err_t st7789_init(st7789_driver_t *driver);
+// Initialize driver with buffers in caller storage of ST7789_STORAGE_SIZE bytes, storage must be DMA capable
+esp_err_t st7789_init_static(st7789_driver_t *driver, void *storage, size_t storage_size);
 void st7789_destroy(st7789_driver_t *driver);
 void st7789_reset(st7789_driver_t *driver);
 void st7789_lcd_init(st7789_driver_t *driver);
@@ -147,44 +166,6 @@ void st7789_fill_area(st7789_driver_t *driver, st7789_color_t color, uint16_t st
 void st7789_set_window(st7789_driver_t *driver, uint16_t start_x, uint16_t start_y, uint16_t end_x, uint16_t end_y);
 void st7789_write_pixels(st7789_driver_t *driver, st7789_color_t *pixels, size_t length);
 void st7789_wait_until_queue_empty(st7789_driver_t *driver);
+void st7789_wait_until_queue_free(st7789_driver_t *driver);
 void st7789_swap_buffers(st7789_driver_t *driver);
-/*
-inline st7789_color_t st7789_rgb_to_color(uint8_t r, uint8_t g, uint8_t b) {
-	return (((uint16_t)r >> 3) << 11) | (((uint16_t)g >> 2) << 5) | ((uint16_t)b >> 3);
-}
-*/
-extern uint8_t st7789_dither_table[];
-void st7789_randomize_dither_table();
-#define st7789_rgb_to_color(r, g, b) ((((st7789_color_t)(r) >> 3) << 11) | (((st7789_color_t)(g) >> 2) << 5) | ((st7789_color_t)(b) >> 3))
-inline st7789_color_t __attribute__((always_inline)) st7789_rgb_to_color_dither(uint8_t r, uint8_t g, uint8_t b, uint16_t x, uint16_t y) {
-	const uint8_t pos = ((y << 8) + (y << 3) + x) & 0xff;
-	uint8_t rand_b = st7789_dither_table[pos];
-	const uint8_t rand_r = rand_b & 0x07;
-	rand_b >>= 3;
-	const uint8_t rand_g = rand_b & 0x03;
-	rand_b >>= 2;
-
-	if (r < 249) {
-		r = r + rand_r;
-	}
-	if (g < 253) {
-		g = g + rand_g;
-	}
-	if (b < 249) {
-		b = b + rand_b;
-	}
-	return st7789_rgb_to_color(r, g, b);
-}
-
-inline void __attribute__((always_inline)) st7789_color_to_rgb(st7789_color_t color, uint8_t *r, uint8_t *g, uint8_t *b) {
-	*b = (color << 3);
-	color >>= 5;
-	color <<= 2;
-	*g = color;
-	color >>= 8;
-	*r = color << 3;
-}
-
-//void st7789_color_to_rgb(st7789_color_t color, uint8_t *r, uint8_t *g, uint8_t *b);
-//st7789_color_t st7789_rgb_to_color_dither(uint8_t r, uint8_t g, uint8_t b, uint16_t x, uint16_t y);
-void st7789_draw_gray2_bitmap(uint8_t *src_buf, st7789_color_t *target_buf, uint8_t r, uint8_t g, uint8_t b, int x, int y, int src_w, int src_h, int target_w, int target_h);
+void st7789_swap_buffers_partial(st7789_driver_t *driver, size_t length);
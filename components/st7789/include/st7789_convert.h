@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stddef.h>
+
+#include "nanogl.h"
+#include "st7789_color.h"
+
+
+// Conversion of RGBA bands to RGB565, kernels build on host for benchmarks
+void st7789_convert_simple(const ngl_color_t *sbuf, st7789_color_t *tbuf, size_t buffer_size);
+// Same conversion with random dithering
+void st7789_convert_dither(const ngl_color_t *sbuf, st7789_color_t *tbuf, size_t buffer_size);
+// Restart random sequence of dithering, seed must not be 0
+void st7789_convert_dither_seed(uint32_t seed);
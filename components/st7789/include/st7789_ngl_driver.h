@@ -1,9 +1,33 @@
 #pragma once
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
 #include "nanogl.h"
 #include "st7789.h"
 
 
+#define ST7789_NGL_DRIVER_FLUSH_STACK_SIZE (configMINIMAL_STACK_SIZE + 1024)
+
+// Upper bounds of private structure sizes, checked at compile time
+#define ST7789_NGL_DRIVER_PRIV_SIZE (sizeof(st7789_driver_t) + sizeof(ngl_buffer_t) + 32 * sizeof(void *) + 16 * sizeof(int64_t))
+#define ST7789_NGL_DRIVER_BAND_SIZE (4 * sizeof(int) + sizeof(void *))
+
+// Bytes of DMA capable storage for st7789_ngl_driver_init_static
+#define ST7789_NGL_DRIVER_STORAGE_SIZE(width, buffer_lines, buffer_count, native_rgb565, pipeline_bands) (ST7789_STORAGE_ALIGN - 1 + \
+	ST7789_STORAGE_ROUND(ST7789_NGL_DRIVER_PRIV_SIZE) + \
+	((native_rgb565) ? 0 : ST7789_NGL_DRIVER_PIPELINE_STORAGE_SIZE((width) * (buffer_lines) * 4, pipeline_bands)) + \
+	ST7789_STORAGE_SIZE((width) * (buffer_lines), buffer_count))
+
+// Band buffers, band ring and flush task of non native modes
+#define ST7789_NGL_DRIVER_PIPELINE_STORAGE_SIZE(band_size, pipeline_bands) ((pipeline_bands) > 1 ? \
+	ST7789_STORAGE_ROUND((band_size) * (pipeline_bands)) + \
+	ST7789_STORAGE_ROUND((pipeline_bands) * ST7789_NGL_DRIVER_BAND_SIZE) + \
+	ST7789_STORAGE_ROUND(sizeof(StaticTask_t)) + \
+	ST7789_STORAGE_ROUND(ST7789_NGL_DRIVER_FLUSH_STACK_SIZE * sizeof(StackType_t)) : \
+	ST7789_STORAGE_ROUND(band_size))
+
+
 typedef struct st7789_ngl_driver_init_struct {
 	int pin_reset;
 	int pin_dc;
@@ -15,8 +39,64 @@ typedef struct st7789_ngl_driver_init_struct {
 	int height;
 	int buffer_lines;
 	int buffer_count;
+	// Render directly to RGB565 DMA buffers, saves RGBA buffer and conversion, disables dithering
+	bool native_rgb565;
+	// Number of band buffers rendered ahead while task on other core converts and sends them, 0 or 1 disables pipeline
+	int pipeline_bands;
 } st7789_ngl_driver_init_struct_t;
 
+// Band layout which can be changed at runtime within capacity allocated by init
+typedef struct st7789_ngl_driver_bands {
+	int buffer_lines;
+	// DMA buffers, at least 2
+	int buffer_count;
+	// Pipeline bands, 1 if pipeline is disabled
+	int pipeline_bands;
+} st7789_ngl_driver_bands_t;
+
+// Band time in microseconds as fixed cost per band plus cost per pixel
+typedef struct st7789_ngl_driver_cost {
+	float band;
+	float pixel;
+} st7789_ngl_driver_cost_t;
+
+// Result of calibration
+typedef struct st7789_ngl_driver_calibration {
+	// Widget drawing between get_window and flush
+	st7789_ngl_driver_cost_t render;
+	// RGBA to RGB565, zero in native mode
+	st7789_ngl_driver_cost_t convert;
+	// Address window and DMA transfer
+	st7789_ngl_driver_cost_t transfer;
+	// Number of measured bands
+	int bands;
+} st7789_ngl_driver_calibration_t;
+
 
 esp_err_t st7789_ngl_driver_init(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config);
+// Initialize driver without heap allocations, storage of ST7789_NGL_DRIVER_STORAGE_SIZE bytes must be DMA capable and valid until destroy
+esp_err_t st7789_ngl_driver_init_static(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config, void *storage, size_t storage_size);
 esp_err_t st7789_ngl_driver_destroy(ngl_driver_t *driver);
+
+/*
+ * Measure bands of next frames, frames alternate between current and half
+ * band height to separate fixed and per pixel costs. Transfers are not
+ * overlapped with rendering while calibrating. If ram_budget is not 0, best
+ * layout within budget is applied at end of calibration.
+ *
+ * Only frames drawing bands are measured, so every calibration frame
+ * invalidates whole screen and requests next one. Must be called from
+ * drawing task.
+ */
+esp_err_t st7789_ngl_driver_calibrate(ngl_driver_t *driver, int frames, size_t ram_budget);
+// Result of finished calibration, ESP_ERR_INVALID_STATE while calibration runs or before it
+esp_err_t st7789_ngl_driver_get_calibration(ngl_driver_t *driver, st7789_ngl_driver_calibration_t *calibration);
+// Estimated time of full screen frame in microseconds
+float st7789_ngl_driver_estimate(ngl_driver_t *driver, const st7789_ngl_driver_calibration_t *calibration, const st7789_ngl_driver_bands_t *bands);
+// Bytes of band and DMA buffers used by layout
+size_t st7789_ngl_driver_bands_memory(ngl_driver_t *driver, const st7789_ngl_driver_bands_t *bands);
+// Fastest layout within ram_budget and allocated capacity, ESP_ERR_NOT_FOUND if no layout fits
+esp_err_t st7789_ngl_driver_tune(ngl_driver_t *driver, const st7789_ngl_driver_calibration_t *calibration, size_t ram_budget, st7789_ngl_driver_bands_t *bands);
+void st7789_ngl_driver_get_bands(ngl_driver_t *driver, st7789_ngl_driver_bands_t *bands);
+// Change layout between frames, waits for pending transfers, ESP_ERR_INVALID_SIZE if layout exceeds allocated capacity
+esp_err_t st7789_ngl_driver_set_bands(ngl_driver_t *driver, const st7789_ngl_driver_bands_t *bands);
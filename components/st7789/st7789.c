@@ -2,13 +2,13 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/param.h>
 
 #include "st7789.h"
 
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
@@ -23,7 +23,11 @@ static void st7789_pre_cb(spi_transaction_t *transaction) {
 }
 
 
+static esp_err_t st7789_setup(st7789_driver_t *driver);
+
+
 esp_err_t st7789_init(st7789_driver_t *driver) {
+	driver->static_storage = false;
 	driver->transactions = (spi_transaction_t *)heap_caps_malloc(driver->buffer_count * sizeof(spi_transaction_t), MALLOC_CAP_DMA);
 	if (driver->transactions == NULL) {
 		ESP_LOGE(TAG, "buffer not allocated");
@@ -33,7 +37,6 @@ esp_err_t st7789_init(st7789_driver_t *driver) {
 		memset(&driver->transactions[i], 0, sizeof(driver->transactions[i]));
 	}
 
-	driver->frame = 0;
 	driver->framebuffers = (st7789_color_t **)heap_caps_malloc(driver->buffer_count * sizeof(st7789_color_t *), MALLOC_CAP_DMA);
 	if (driver->framebuffers == NULL) {
 		heap_caps_free(driver->transactions);
@@ -51,13 +54,44 @@ esp_err_t st7789_init(st7789_driver_t *driver) {
 			ESP_LOGE(TAG, "buffer not allocated");
 			return ESP_FAIL;
 		}
-		else {
-			driver->framebuffers[i].format = NGL_RGBA;
-		}
 	}
 
+	return st7789_setup(driver);
+}
+
+
+/* Take aligned part of caller storage */
+static void *st7789_storage_take(uint8_t **storage, size_t size) {
+	uint8_t *part = (uint8_t *)ST7789_STORAGE_ROUND((uintptr_t)*storage);
+	*storage = part + ST7789_STORAGE_ROUND(size);
+	return part;
+}
+
+
+esp_err_t st7789_init_static(st7789_driver_t *driver, void *storage, size_t storage_size) {
+	if (storage_size < ST7789_STORAGE_SIZE(driver->buffer_size, driver->buffer_count)) {
+		ESP_LOGE(TAG, "storage too small");
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	uint8_t *data = (uint8_t *)storage;
+	driver->static_storage = true;
+	driver->transactions = (spi_transaction_t *)st7789_storage_take(&data, driver->buffer_count * sizeof(spi_transaction_t));
+	memset(driver->transactions, 0, driver->buffer_count * sizeof(spi_transaction_t));
+	driver->framebuffers = (st7789_color_t **)st7789_storage_take(&data, driver->buffer_count * sizeof(st7789_color_t *));
+	for (size_t i = 0; i < driver->buffer_count; ++i) {
+		driver->framebuffers[i] = (st7789_color_t *)st7789_storage_take(&data, driver->buffer_size * sizeof(st7789_color_t));
+	}
+
+	return st7789_setup(driver);
+}
+
+
+static esp_err_t st7789_setup(st7789_driver_t *driver) {
 	driver->current_buffer = driver->framebuffers[0];
 	driver->queue_fill = 0;
+	driver->bytes_queued = 0;
+	driver->queue_wait_us = 0;
 	driver->spi = 0;
 	driver->current_buffer_num = 0;
 
@@ -105,11 +139,13 @@ void st7789_destroy(st7789_driver_t *driver) {
 	//free(driver->buffer);
 	//driver->buffer = NULL;
 
-	for (size_t i = 0; i < driver->buffer_count; ++i) {
-		heap_caps_free(driver->framebuffers[i]);
+	if (!driver->static_storage) {
+		for (size_t i = 0; i < driver->buffer_count; ++i) {
+			heap_caps_free(driver->framebuffers[i]);
+		}
+		heap_caps_free(driver->framebuffers);
+		heap_caps_free(driver->transactions);
 	}
-	heap_caps_free(driver->framebuffers);
-	heap_caps_free(driver->transactions);
 	spi_bus_remove_device(driver->spi);
 	spi_bus_free(driver->spi_host);
 }
@@ -217,6 +253,8 @@ void st7789_run_command(st7789_driver_t *driver, const st7789_command_t *command
 		spi_device_get_trans_result(driver->spi, &rtrans, portMAX_DELAY);
 	}
 
+	driver->bytes_queued += 1 + command->data_size;
+
 	if (command->wait_ms > 0) {
 		vTaskDelay(command->wait_ms / portTICK_PERIOD_MS);
 	}
@@ -261,6 +299,7 @@ void st7789_fill_area(st7789_driver_t *driver, st7789_color_t color, uint16_t st
 		}
 		spi_device_queue_trans(driver->spi, &trans, portMAX_DELAY);
 		driver->queue_fill++;
+		driver->bytes_queued += transfer_size;
 		bytes_to_write -= transfer_size;
 	}
 
@@ -298,6 +337,7 @@ void st7789_write_pixels(st7789_driver_t *driver, st7789_color_t *pixels, size_t
 
 	spi_device_queue_trans(driver->spi, trans, portMAX_DELAY);
 	driver->queue_fill++;
+	driver->bytes_queued += length * sizeof(st7789_color_t);
 }
 
 void st7789_wait_until_queue_empty(st7789_driver_t *driver) {
@@ -310,111 +350,28 @@ void st7789_wait_until_queue_empty(st7789_driver_t *driver) {
 
 void st7789_wait_until_queue_free(st7789_driver_t *driver) {
 	spi_transaction_t *rtrans;
+	// Clock is read only when transfer must be waited for
+	if (driver->queue_fill <= driver->buffer_count - 2) {
+		return;
+	}
+	const int64_t start = esp_timer_get_time();
 	while (driver->queue_fill > driver->buffer_count - 2) {
 		spi_device_get_trans_result(driver->spi, &rtrans, portMAX_DELAY);
 		driver->queue_fill--;
 	}
+	driver->queue_wait_us += esp_timer_get_time() - start;
 }
 
 void st7789_swap_buffers(st7789_driver_t *driver) {
+	st7789_swap_buffers_partial(driver, driver->buffer_size);
+}
+
+void st7789_swap_buffers_partial(st7789_driver_t *driver, size_t length) {
 	st7789_wait_until_queue_free(driver);
-	st7789_write_pixels(driver, driver->current_buffer, driver->buffer_size);
+	st7789_write_pixels(driver, driver->current_buffer, length);
 	driver->current_buffer_num++;
 	if (driver->current_buffer_num >= driver->buffer_count) {
 		driver->current_buffer_num = 0;
 	}
 	driver->current_buffer = driver->framebuffers[driver->current_buffer_num];
 }
-
-
-uint8_t st7789_dither_table[256] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-void st7789_randomize_dither_table() {
-	uint16_t *dither_table = (uint16_t *)st7789_dither_table;
-	for (size_t i = 0; i < sizeof(st7789_dither_table) / 2; ++i) {
-		dither_table[i] = rand() & 0xffff;
-	}
-}
-
-
-void st7789_draw_gray2_bitmap(uint8_t *src_buf, st7789_color_t *target_buf, uint8_t r, uint8_t g, uint8_t b, int x, int y, int src_w, int src_h, int target_w, int target_h) {
-	if (x >= target_w || y >= target_h || x + src_w <= 0 || y + src_h <= 0) {
-		return;
-	}
-
-	const size_t src_size = src_w * src_h;
-	const size_t target_size = target_w * target_h;
-	const size_t line_w = MIN(src_w + x, target_w) - MAX(x, 0);
-	const size_t src_skip = src_w - line_w;
-	const size_t target_skip = target_w - line_w;
-	size_t src_pos = 0;
-	size_t target_pos = 0;
-	size_t x_pos = 0;
-	size_t y_pos = 0;
-
-	if (y < 0) {
-		src_pos = (-y) * src_w;
-	}
-	if (x < 0) {
-		src_pos -= x;
-	}
-	if (y > 0) {
-		target_pos = y * target_w;
-	}
-	if (x > 0) {
-		target_pos += x;
-	}
-
-	while (src_pos < src_size && target_pos < target_size) {
-		uint8_t src_r, src_g, src_b;
-		uint8_t target_r, target_g, target_b;
-		st7789_color_to_rgb(target_buf[target_pos], &src_r, &src_g, &src_b);
-		uint8_t gray2_color = (src_buf[src_pos >> 2] >> ((src_pos & 0x03) << 1)) & 0x03;
-		/*
-		static const uint32_t src_weights = 0x002b5580;
-		static const uint32_t target_weights = 0x80552b00;
-		const uint32_t src_weight = (src_weights >> (gray2_color << 3)) & 0xff;
-		const uint32_t target_weight = (target_weights >> (gray2_color << 3)) & 0xff;
-		target_r = ((src_weight * src_r) + (target_weight * r)) >> 7;
-		target_g = ((src_weight * src_g) + (target_weight * g)) >> 7;
-		target_b = ((src_weight * src_b) + (target_weight * b)) >> 7;
-		target_buf[target_pos] = st7789_rgb_to_color_dither(target_r, target_g, target_b, x_pos, y_pos);
-		*/
-		switch(gray2_color) {
-			case 1:
-				target_r = r >> 1;
-				target_g = g >> 1;
-				target_b = b >> 1;
-				src_r = (src_r >> 1) + target_r;
-				src_g = (src_g >> 1) + target_g;
-				src_b = (src_b >> 1) + target_b;
-				target_buf[target_pos] = st7789_rgb_to_color_dither(src_r, src_g, src_b, x_pos, y_pos);
-				break;
-			case 2:
-				target_r = r >> 2;
-				target_g = g >> 2;
-				target_b = b >> 2;
-				src_r = (src_r >> 2) + target_r + target_r + target_r;
-				src_g = (src_g >> 2) + target_g + target_g + target_g;
-				src_b = (src_b >> 2) + target_b + target_b + target_b;
-				target_buf[target_pos] = st7789_rgb_to_color_dither(src_r, src_g, src_b, x_pos, y_pos);
-				break;
-			case 3:
-				target_buf[target_pos] = st7789_rgb_to_color_dither(r, g, b, x_pos, y_pos);
-				break;
-			default:
-				break;
-		}
-
-		x_pos++;
-
-		if (x_pos == line_w) {
-			x_pos = 0;
-			y_pos++;
-			src_pos += src_skip;
-			target_pos += target_skip;
-		}
-		src_pos++;
-		target_pos++;
-	}
-}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: MIT
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "st7789_convert.h"
+
+
+static uint32_t rng = 0x12345678;
+
+
+// Display is switched to little endian, first pixel is in lower half of word like in native uint16_t buffer
+#define st7789_color_pack(c1, c2) (((uint32_t)c2.rgba.r << 24) | (c2.rgba.g << 19) | (c2.rgba.b << 13) | (c1.rgba.r << 8) | (c1.rgba.g << 3) | (c1.rgba.b >> 3))
+
+
+
+void st7789_convert_simple(const ngl_color_t *sbuf, st7789_color_t *tbuf, size_t buffer_size) {
+	static const uint32_t col_mask = 0x00f8fcf8;
+
+	const size_t count = buffer_size >> 2;
+
+	uint32_t *tptr = (uint32_t *)tbuf;
+	const ngl_color_t *sptr = sbuf;
+
+	for (size_t i = count << 2; i < buffer_size; ++i) {
+		tbuf[i] = st7789_rgb_to_color(sbuf[i].rgba.r, sbuf[i].rgba.g, sbuf[i].rgba.b);
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		ngl_color_t color1 = sptr[0];
+		ngl_color_t color2 = sptr[1];
+		color1.value = color1.value & col_mask;
+		color2.value = color2.value & col_mask;
+		tptr[0] = st7789_color_pack(color1, color2);
+
+		color1 = sptr[2];
+		color2 = sptr[3];
+		color1.value = color1.value & col_mask;
+		color2.value = color2.value & col_mask;
+		tptr[1] = st7789_color_pack(color1, color2);
+
+		tptr += 2;
+		sptr += 4;
+	}
+}
+
+
+void st7789_convert_dither(const ngl_color_t *sbuf, st7789_color_t *tbuf, size_t buffer_size) {
+	static const uint32_t col_sub_mask = 0x00e000e0;
+	static const uint32_t rng_mask = 0x00070307;
+
+	const size_t count = buffer_size >> 2;
+
+	uint32_t *tptr = (uint32_t *)tbuf;
+	const ngl_color_t *sptr = sbuf;
+
+	for (size_t i = count << 2; i < buffer_size; ++i) {
+		tbuf[i] = st7789_rgb_to_color(sbuf[i].rgba.r, sbuf[i].rgba.g, sbuf[i].rgba.b);
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+
+		ngl_color_t color1 = sptr[0];
+		color1.value -= ((color1.value & col_sub_mask) >> 5);
+		color1.rgba.g -= (color1.rgba.g >> 6);
+		color1.value += (rng & rng_mask);
+
+		ngl_color_t color2 = sptr[1];
+		color2.value -= ((color2.value & col_sub_mask) >> 5);
+		color2.rgba.g -= (color2.rgba.g >> 6);
+		color2.value += ((rng >> 2) & rng_mask);
+
+		tptr[0] = st7789_rgb_to_color(color1.rgba.r, color1.rgba.g, color1.rgba.b) | ((uint32_t)st7789_rgb_to_color(color2.rgba.r, color2.rgba.g, color2.rgba.b) << 16);
+
+		color1 = sptr[2];
+		color1.value -= ((color1.value & col_sub_mask) >> 5);
+		color1.rgba.g -= (color1.rgba.g >> 6);
+		color1.value += ((rng >> 4) & rng_mask);
+
+		color2 = sptr[3];
+		color2.value -= ((color2.value & col_sub_mask) >> 5);
+		color2.rgba.g -= (color2.rgba.g >> 6);
+		color2.value += ((rng >> 6) & rng_mask);
+
+		tptr[1] = st7789_rgb_to_color(color1.rgba.r, color1.rgba.g, color1.rgba.b) | ((uint32_t)st7789_rgb_to_color(color2.rgba.r, color2.rgba.g, color2.rgba.b) << 16);
+
+		tptr += 2;
+		sptr += 4;
+	}
+}
+
+
+void st7789_convert_dither_seed(uint32_t seed) {
+	rng = seed;
+}
+
+
+uint8_t st7789_dither_table[256] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+void st7789_randomize_dither_table() {
+	uint16_t *dither_table = (uint16_t *)st7789_dither_table;
+	for (size_t i = 0; i < sizeof(st7789_dither_table) / 2; ++i) {
+		dither_table[i] = rand() & 0xffff;
+	}
+}
+
+
+void st7789_draw_gray2_bitmap(uint8_t *src_buf, st7789_color_t *target_buf, uint8_t r, uint8_t g, uint8_t b, int x, int y, int src_w, int src_h, int target_w, int target_h) {
+	if (x >= target_w || y >= target_h || x + src_w <= 0 || y + src_h <= 0) {
+		return;
+	}
+
+	const size_t src_size = src_w * src_h;
+	const size_t target_size = target_w * target_h;
+	const size_t line_w = MIN(src_w + x, target_w) - MAX(x, 0);
+	const size_t src_skip = src_w - line_w;
+	const size_t target_skip = target_w - line_w;
+	size_t src_pos = 0;
+	size_t target_pos = 0;
+	size_t x_pos = 0;
+	size_t y_pos = 0;
+
+	if (y < 0) {
+		src_pos = (-y) * src_w;
+	}
+	if (x < 0) {
+		src_pos -= x;
+	}
+	if (y > 0) {
+		target_pos = y * target_w;
+	}
+	if (x > 0) {
+		target_pos += x;
+	}
+
+	while (src_pos < src_size && target_pos < target_size) {
+		uint8_t src_r, src_g, src_b;
+		uint8_t target_r, target_g, target_b;
+		st7789_color_to_rgb(target_buf[target_pos], &src_r, &src_g, &src_b);
+		uint8_t gray2_color = (src_buf[src_pos >> 2] >> ((src_pos & 0x03) << 1)) & 0x03;
+		/*
+		static const uint32_t src_weights = 0x002b5580;
+		static const uint32_t target_weights = 0x80552b00;
+		const uint32_t src_weight = (src_weights >> (gray2_color << 3)) & 0xff;
+		const uint32_t target_weight = (target_weights >> (gray2_color << 3)) & 0xff;
+		target_r = ((src_weight * src_r) + (target_weight * r)) >> 7;
+		target_g = ((src_weight * src_g) + (target_weight * g)) >> 7;
+		target_b = ((src_weight * src_b) + (target_weight * b)) >> 7;
+		target_buf[target_pos] = st7789_rgb_to_color_dither(target_r, target_g, target_b, x_pos, y_pos);
+		*/
+		switch(gray2_color) {
+			case 1:
+				target_r = r >> 1;
+				target_g = g >> 1;
+				target_b = b >> 1;
+				src_r = (src_r >> 1) + target_r;
+				src_g = (src_g >> 1) + target_g;
+				src_b = (src_b >> 1) + target_b;
+				target_buf[target_pos] = st7789_rgb_to_color_dither(src_r, src_g, src_b, x_pos, y_pos);
+				break;
+			case 2:
+				target_r = r >> 2;
+				target_g = g >> 2;
+				target_b = b >> 2;
+				src_r = (src_r >> 2) + target_r + target_r + target_r;
+				src_g = (src_g >> 2) + target_g + target_g + target_g;
+				src_b = (src_b >> 2) + target_b + target_b + target_b;
+				target_buf[target_pos] = st7789_rgb_to_color_dither(src_r, src_g, src_b, x_pos, y_pos);
+				break;
+			case 3:
+				target_buf[target_pos] = st7789_rgb_to_color_dither(r, g, b, x_pos, y_pos);
+				break;
+			default:
+				break;
+		}
+
+		x_pos++;
+
+		if (x_pos == line_w) {
+			x_pos = 0;
+			y_pos++;
+			src_pos += src_skip;
+			target_pos += target_skip;
+		}
+		src_pos++;
+		target_pos++;
+	}
+}
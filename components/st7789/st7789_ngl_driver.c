@@ -1,5 +1,11 @@
+#include <string.h>
+#include <sys/param.h>
+
+#include "st7789_convert.h"
 #include "st7789_ngl_driver.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nanogl/profile.h"
 
 #include "freertos/task.h"
 
@@ -7,160 +13,438 @@
 static const char *TAG = "st7789_ngl_driver";
 
 
+/* Rendered band waiting for conversion */
+typedef struct st7789_ngl_driver_band {
+	ngl_area_t area;
+	ngl_byte_t *buffer;
+} st7789_ngl_driver_band_t;
+
+
+/* Measured stages of band */
+typedef enum st7789_ngl_driver_stage {
+	ST7789_NGL_DRIVER_RENDER,
+	ST7789_NGL_DRIVER_CONVERT,
+	ST7789_NGL_DRIVER_TRANSFER,
+	ST7789_NGL_DRIVER_STAGE_COUNT,
+} st7789_ngl_driver_stage_t;
+
+
+/* Sums for least squares fit of band time to number of pixels */
+typedef struct st7789_ngl_driver_samples {
+	int64_t count;
+	int64_t pixels;
+	int64_t pixels_sq;
+	int64_t time;
+	int64_t pixels_time;
+} st7789_ngl_driver_samples_t;
+
+
 typedef struct st7789_ngl_driver_priv {
+	// Buffers of all bands, single band without pipeline
 	ngl_byte_t *framebuffer;
 	ngl_buffer_t buffer;
 	st7789_driver_t display;
 	size_t buffer_size;
 	int buffer_lines;
+	// Rendering directly to RGB565 DMA buffers
+	bool native;
+	// Address window currently set on display
+	ngl_area_t window;
+	// Next line written to address window
+	int window_row;
+
+	// Pipelined mode, single producer single consumer ring of rendered bands
+	st7789_ngl_driver_band_t *bands;
+	size_t band_count;
+	// Written only by rendering task
+	size_t band_head;
+	// Written only by flush task
+	size_t band_tail;
+	TaskHandle_t render_task;
+	TaskHandle_t flush_task;
+	bool stop;
+
+	// Allocated capacity, limit of runtime band layout
+	int capacity_lines;
+	int capacity_count;
+	int capacity_bands;
+
+	// Calibration runs while frames remain
+	int calibration_frames;
+	int calibration_lines;
+	int calibration_frame_bands;
+	size_t calibration_budget;
+	bool calibrated;
+	int64_t band_start;
+	st7789_ngl_driver_samples_t samples[ST7789_NGL_DRIVER_STAGE_COUNT];
+
+	// Statistics, written by task sending bands
+	uint32_t pixels_converted;
+
+	// Memory is in caller storage
+	bool static_storage;
 } st7789_ngl_driver_priv_t;
 
+_Static_assert(sizeof(st7789_ngl_driver_priv_t) <= ST7789_NGL_DRIVER_PRIV_SIZE, "ST7789_NGL_DRIVER_PRIV_SIZE too small");
+_Static_assert(sizeof(st7789_ngl_driver_band_t) <= ST7789_NGL_DRIVER_BAND_SIZE, "ST7789_NGL_DRIVER_BAND_SIZE too small");
 
 
-static ngl_buffer_t *st7789_ngl_driver_get_buffer(ngl_driver_t *driver) {
+
+static ngl_buffer_t *st7789_ngl_driver_get_window(ngl_driver_t *driver, ngl_area_t *area) {
 	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
 
-	driver_priv->buffer.area.y += driver_priv->buffer_lines;
-	if (driver_priv->buffer.area.y >= driver->height) {
-		driver_priv->buffer.area.y = 0;
+	// Narrow windows can use more lines of same buffer
+	int buffer_height = (driver->width * driver_priv->buffer_lines) / area->width;
+	if (buffer_height > area->height) {
+		buffer_height = area->height;
 	}
-	int buffer_height = driver->height - driver_priv->buffer.area.y;
-	if (buffer_height > driver_priv->buffer_lines) {
-		buffer_height = driver_priv->buffer_lines;
+	if (buffer_height > driver->height - area->y) {
+		buffer_height = driver->height - area->y;
 	}
+	driver_priv->buffer.area.x = area->x;
+	driver_priv->buffer.area.y = area->y;
+	driver_priv->buffer.area.width = area->width;
 	driver_priv->buffer.area.height = buffer_height;
+	driver_priv->buffer.stride = area->width;
+	if (driver_priv->native) {
+		driver_priv->buffer.buffer = (ngl_byte_t *)driver_priv->display.current_buffer;
+	}
+	else if (driver_priv->bands != NULL) {
+		// Wait until flush task releases oldest band
+		NGL_PROFILE_BEGIN(driver, span);
+		driver_priv->render_task = xTaskGetCurrentTaskHandle();
+		while (driver_priv->band_head - __atomic_load_n(&driver_priv->band_tail, __ATOMIC_ACQUIRE) == driver_priv->band_count) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}
+		NGL_PROFILE_END(driver, span, NGL_PROFILE_QUEUE_WAIT, NULL, 1);
+		driver_priv->buffer.buffer = driver_priv->bands[driver_priv->band_head % driver_priv->band_count].buffer;
+	}
+	if (driver_priv->calibration_frames > 0) {
+		driver_priv->band_start = esp_timer_get_time();
+	}
 	return &driver_priv->buffer;
 }
 
 
-static uint32_t rng = 0x12345678;
+static ngl_buffer_t *st7789_ngl_driver_get_buffer(ngl_driver_t *driver) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+
+	ngl_area_t area = {0, 0, driver->width, driver->height};
+	if (driver_priv->buffer.area.y + driver_priv->buffer.area.height < driver->height) {
+		area.y = driver_priv->buffer.area.y + driver_priv->buffer.area.height;
+		area.height -= area.y;
+	}
+	return st7789_ngl_driver_get_window(driver, &area);
+}
 
 
-#define st7789_color_pack(c1, c2) ((c1.rgba.r << 24) | (c1.rgba.g << 19) | (c1.rgba.b << 13) | (c2.rgba.r << 8) | (c2.rgba.g << 3) | (c2.rgba.b >> 3))
+static void st7789_ngl_driver_sample(st7789_ngl_driver_priv_t *driver_priv, st7789_ngl_driver_stage_t stage, size_t pixels, int64_t time) {
+	st7789_ngl_driver_samples_t *samples = &driver_priv->samples[stage];
+	samples->count++;
+	samples->pixels += pixels;
+	samples->pixels_sq += (int64_t)pixels * pixels;
+	samples->time += time;
+	samples->pixels_time += (int64_t)pixels * time;
+}
 
 
+static st7789_ngl_driver_cost_t st7789_ngl_driver_fit(const st7789_ngl_driver_samples_t *samples) {
+	st7789_ngl_driver_cost_t cost = {0.0f, 0.0f};
+	if (samples->count == 0) {
+		return cost;
+	}
+	const double count = samples->count;
+	const double mean_pixels = samples->pixels / count;
+	const double mean_time = samples->time / count;
+	const double variance = samples->pixels_sq / count - mean_pixels * mean_pixels;
+	double pixel = mean_pixels > 0 ? mean_time / mean_pixels : 0;
+	if (variance > 1.0) {
+		pixel = (samples->pixels_time / count - mean_pixels * mean_time) / variance;
+	}
+	// Noise must not produce negative costs
+	pixel = MAX(pixel, 0.0);
+	double band = mean_time - pixel * mean_pixels;
+	if (band < 0) {
+		band = 0;
+		pixel = mean_pixels > 0 ? mean_time / mean_pixels : 0;
+	}
+	cost.band = band;
+	cost.pixel = pixel;
+	return cost;
+}
 
-static void st7789_ngl_driver_flush_simple(ngl_driver_t *driver) {
-	static const uint32_t col_mask = 0x00f8fcf8;
 
+static void st7789_ngl_driver_set_window(ngl_driver_t *driver, ngl_area_t *area) {
 	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
-	ngl_color_t *sbuf = (ngl_color_t *)driver_priv->buffer.buffer;
-	st7789_color_t *tbuf = driver_priv->display.current_buffer;
-	const size_t buffer_size = driver_priv->buffer.area.width * driver_priv->buffer.area.height;
-	const size_t count = buffer_size >> 2;
-
-	uint32_t *tptr = (uint32_t *)tbuf;
-	ngl_color_t *sptr = sbuf;
+	ngl_area_t *window = &driver_priv->window;
+
+	// Continuous write to current window does not need any command
+	if (area->x != window->x || area->width != window->width || area->y != driver_priv->window_row) {
+		window->x = area->x;
+		window->y = area->y;
+		window->width = area->width;
+		window->height = driver->height - area->y;
+		st7789_set_window(&driver_priv->display, window->x, window->y, window->x + window->width - 1, window->y + window->height - 1);
+	}
 
-	for (size_t i = 0; i < count; ++i) {
-		ngl_color_t color1 = sptr[0];
-		ngl_color_t color2 = sptr[1];
-		color1.value = color1.value & col_mask;
-		color2.value = color2.value & col_mask;
-		tptr[0] = st7789_color_pack(color1, color2);
+	driver_priv->window_row = area->y + area->height;
+	if (driver_priv->window_row >= window->y + window->height) {
+		driver_priv->window_row = window->y;
+	}
+}
 
-		color1 = sptr[2];
-		color2 = sptr[3];
-		color1.value = color1.value & col_mask;
-		color2.value = color2.value & col_mask;
-		tptr[1] = st7789_color_pack(color1, color2);
 
-		tptr += 2;
-		sptr += 4;
+/* Convert band to current DMA buffer and send it to display */
+static void st7789_ngl_driver_send_band(ngl_driver_t *driver, ngl_area_t *area, ngl_byte_t *buffer) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	const size_t pixels = area->width * area->height;
+	const bool calibrating = __atomic_load_n(&driver_priv->calibration_frames, __ATOMIC_RELAXED) > 0;
+	int64_t start = calibrating ? esp_timer_get_time() : 0;
+	NGL_PROFILE_BEGIN(driver, convert_span);
+	if (driver_priv->native) {
+		// Already rendered to DMA buffer
+	}
+	else if (driver_priv->display.dither) {
+		driver_priv->pixels_converted += pixels;
+		st7789_convert_dither((const ngl_color_t *)buffer, driver_priv->display.current_buffer, pixels);
+	}
+	else {
+		driver_priv->pixels_converted += pixels;
+		st7789_convert_simple((const ngl_color_t *)buffer, driver_priv->display.current_buffer, pixels);
+	}
+	NGL_PROFILE_END(driver, convert_span, NGL_PROFILE_CONVERT, NULL, pixels);
+	if (calibrating) {
+		const int64_t now = esp_timer_get_time();
+		st7789_ngl_driver_sample(driver_priv, ST7789_NGL_DRIVER_CONVERT, pixels, now - start);
+		start = now;
+	}
+	st7789_ngl_driver_set_window(driver, area);
+	// Swap waits for free DMA buffer, wait is measured separately
+	NGL_PROFILE_BEGIN(driver, wait_span);
+	st7789_wait_until_queue_free(&driver_priv->display);
+	NGL_PROFILE_END(driver, wait_span, NGL_PROFILE_QUEUE_WAIT, NULL, 0);
+	st7789_swap_buffers_partial(&driver_priv->display, pixels);
+	if (calibrating) {
+		// Transfer is measured alone, queue was empty before this band
+		st7789_wait_until_queue_empty(&driver_priv->display);
+		st7789_ngl_driver_sample(driver_priv, ST7789_NGL_DRIVER_TRANSFER, pixels, esp_timer_get_time() - start);
 	}
 }
 
 
-static void st7789_ngl_driver_flush_dither(ngl_driver_t *driver) {
-	static const uint32_t col_sub_mask = 0x00e000e0;
-	static const uint32_t rng_mask = 0x00070307;
+/* Second stage of pipeline, converts and sends bands while next bands are rendered */
+static void st7789_ngl_driver_flush_task(void *arg) {
+	ngl_driver_t *driver = (ngl_driver_t *)arg;
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+
+	while (1) {
+		while (__atomic_load_n(&driver_priv->band_head, __ATOMIC_ACQUIRE) == driver_priv->band_tail) {
+			if (__atomic_load_n(&driver_priv->stop, __ATOMIC_ACQUIRE)) {
+				__atomic_store_n(&driver_priv->flush_task, NULL, __ATOMIC_RELEASE);
+				xTaskNotifyGive(driver_priv->render_task);
+				vTaskDelete(NULL);
+				return;
+			}
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}
 
+		st7789_ngl_driver_band_t *band = &driver_priv->bands[driver_priv->band_tail % driver_priv->band_count];
+		st7789_ngl_driver_send_band(driver, &band->area, band->buffer);
+
+		__atomic_store_n(&driver_priv->band_tail, driver_priv->band_tail + 1, __ATOMIC_RELEASE);
+		xTaskNotifyGive(driver_priv->render_task);
+	}
+}
+
+
+static void st7789_ngl_driver_flush(ngl_driver_t *driver) {
 	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
-	ngl_color_t *sbuf = (ngl_color_t *)driver_priv->buffer.buffer;
-	st7789_color_t *tbuf = driver_priv->display.current_buffer;
-	const size_t buffer_size = driver_priv->buffer.area.width * driver_priv->buffer.area.height;
-	const size_t count = buffer_size >> 2;
+	if (driver_priv->calibration_frames > 0) {
+		st7789_ngl_driver_sample(driver_priv, ST7789_NGL_DRIVER_RENDER, driver_priv->buffer.area.width * driver_priv->buffer.area.height, esp_timer_get_time() - driver_priv->band_start);
+		driver_priv->calibration_frame_bands++;
+	}
+	if (driver_priv->bands != NULL) {
+		driver_priv->bands[driver_priv->band_head % driver_priv->band_count].area = driver_priv->buffer.area;
+		__atomic_store_n(&driver_priv->band_head, driver_priv->band_head + 1, __ATOMIC_RELEASE);
+		xTaskNotifyGive(driver_priv->flush_task);
+	}
+	else {
+		st7789_ngl_driver_send_band(driver, &driver_priv->buffer.area, driver_priv->buffer.buffer);
+	}
+}
 
-	uint32_t *tptr = (uint32_t *)tbuf;
-	ngl_color_t *sptr = sbuf;
 
-	for (size_t i = 0; i < count; ++i) {
-		rng ^= rng << 13;
-		rng ^= rng >> 17;
-		rng ^= rng << 5;
+/* Wait until flush task sends all rendered bands */
+static void st7789_ngl_driver_sync(st7789_ngl_driver_priv_t *driver_priv) {
+	if (driver_priv->bands == NULL) {
+		return;
+	}
+	driver_priv->render_task = xTaskGetCurrentTaskHandle();
+	while (__atomic_load_n(&driver_priv->band_tail, __ATOMIC_ACQUIRE) != driver_priv->band_head) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
 
-		ngl_color_t color1 = sptr[0];
-		color1.value -= ((color1.value & col_sub_mask) >> 5);
-		color1.rgba.g -= (color1.rgba.g >> 6);
-		color1.value += (rng & rng_mask);
 
-		ngl_color_t color2 = sptr[1];
-		color2.value -= ((color2.value & col_sub_mask) >> 5);
-		color2.rgba.g -= (color2.rgba.g >> 6);
-		color2.value += ((rng >> 2) & rng_mask);
+static void st7789_ngl_driver_get_stats(ngl_driver_t *driver, ngl_stats_t *stats) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	stats->pixels_converted = driver_priv->pixels_converted;
+	stats->bus_bytes = driver_priv->display.bytes_queued;
+	stats->queue_wait_us = driver_priv->display.queue_wait_us;
+}
 
-		tptr[0] = (st7789_rgb_to_color(color1.rgba.r, color1.rgba.g, color1.rgba.b) << 16) | st7789_rgb_to_color(color2.rgba.r, color2.rgba.g, color2.rgba.b);
 
-		color1 = sptr[2];
-		color1.value -= ((color1.value & col_sub_mask) >> 5);
-		color1.rgba.g -= (color1.rgba.g >> 6);
-		color1.value += ((rng >> 4) & rng_mask);
+static void st7789_ngl_driver_end_frame(ngl_driver_t *driver) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	// Frames without any band are not measured
+	if (driver_priv->calibration_frames == 0 || driver_priv->calibration_frame_bands == 0) {
+		return;
+	}
+	driver_priv->calibration_frame_bands = 0;
+	st7789_ngl_driver_sync(driver_priv);
+	const int frames = driver_priv->calibration_frames - 1;
+	__atomic_store_n(&driver_priv->calibration_frames, frames, __ATOMIC_RELEASE);
+	if (frames > 0) {
+		// Second height separates fixed cost of band from cost of pixels
+		driver_priv->buffer_lines = (frames & 1) ? MAX(driver_priv->calibration_lines / 2, 1) : driver_priv->calibration_lines;
+		// Static screen would never draw rest of calibration frames
+		ngl_invalidate(driver);
+		return;
+	}
 
-		color2 = sptr[3];
-		color2.value -= ((color2.value & col_sub_mask) >> 5);
-		color2.rgba.g -= (color2.rgba.g >> 6);
-		color2.value += ((rng >> 6) & rng_mask);
+	driver_priv->buffer_lines = driver_priv->calibration_lines;
+	driver_priv->calibrated = true;
+	if (driver_priv->calibration_budget == 0) {
+		return;
+	}
+	st7789_ngl_driver_calibration_t calibration;
+	st7789_ngl_driver_bands_t bands;
+	st7789_ngl_driver_get_calibration(driver, &calibration);
+	if (st7789_ngl_driver_tune(driver, &calibration, driver_priv->calibration_budget, &bands) != ESP_OK) {
+		ESP_LOGW(TAG, "no band layout fits to %u bytes", (unsigned)driver_priv->calibration_budget);
+		return;
+	}
+	st7789_ngl_driver_set_bands(driver, &bands);
+	ESP_LOGI(TAG, "tuned to %d lines, %d buffers, %d pipeline bands, frame %.0f us", bands.buffer_lines, bands.buffer_count, bands.pipeline_bands, st7789_ngl_driver_estimate(driver, &calibration, &bands));
+}
 
-		tptr[1] = (st7789_rgb_to_color(color1.rgba.r, color1.rgba.g, color1.rgba.b) << 16) | st7789_rgb_to_color(color2.rgba.r, color2.rgba.g, color2.rgba.b);
 
-		tptr += 2;
-		sptr += 4;
+/* Wait until flush task sends all bands and stop it */
+static void st7789_ngl_driver_stop_pipeline(st7789_ngl_driver_priv_t *driver_priv) {
+	if (driver_priv->flush_task == NULL) {
+		return;
+	}
+	driver_priv->render_task = xTaskGetCurrentTaskHandle();
+	__atomic_store_n(&driver_priv->stop, true, __ATOMIC_RELEASE);
+	xTaskNotifyGive(driver_priv->flush_task);
+	while (__atomic_load_n(&driver_priv->flush_task, __ATOMIC_ACQUIRE) != NULL) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 	}
 }
 
 
-static void st7789_ngl_driver_flush(ngl_driver_t *driver) {
-	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
-	if (driver_priv->display.dither) {
-		st7789_ngl_driver_flush_dither(driver);
+/* Take aligned part of caller storage or allocate it if there is no storage */
+static void *st7789_ngl_driver_alloc(uint8_t **storage, size_t size, uint32_t caps) {
+	if (*storage == NULL) {
+		return heap_caps_malloc(size, caps);
 	}
-	else {
-		st7789_ngl_driver_flush_simple(driver);
+	uint8_t *part = (uint8_t *)ST7789_STORAGE_ROUND((uintptr_t)*storage);
+	*storage = part + ST7789_STORAGE_ROUND(size);
+	return part;
+}
+
+
+/* Release memory of partially initialized driver */
+static void st7789_ngl_driver_free(ngl_driver_t *driver) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	if (!driver_priv->static_storage) {
+		heap_caps_free(driver_priv->bands);
+		heap_caps_free(driver_priv->framebuffer);
+		heap_caps_free(driver_priv);
 	}
-	st7789_swap_buffers(&driver_priv->display);
+	driver->priv = NULL;
 }
 
 
-esp_err_t st7789_ngl_driver_init(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config) {
+static esp_err_t st7789_ngl_driver_init_storage(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config, uint8_t *storage, size_t storage_size) {
+	uint8_t *const storage_start = storage;
 	driver->priv = NULL;
 
-	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)malloc(sizeof(st7789_ngl_driver_priv_t));
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)st7789_ngl_driver_alloc(&storage, sizeof(st7789_ngl_driver_priv_t), MALLOC_CAP_DEFAULT);
 	if (driver_priv == NULL) {
 		ESP_LOGE(TAG, "driver not allocated");
 		return ESP_FAIL;
 	}
 
+	driver_priv->static_storage = storage != NULL;
 	driver_priv->display.framebuffers = NULL;
 
 	driver->priv = driver_priv;
 	driver->flush = st7789_ngl_driver_flush;
 	driver->get_buffer = st7789_ngl_driver_get_buffer;
+	driver->get_window = st7789_ngl_driver_get_window;
+	driver->end_frame = st7789_ngl_driver_end_frame;
+	driver->get_stats = st7789_ngl_driver_get_stats;
 	driver->width = config->width;
 	driver->height = config->height;
-	driver->format = NGL_RGBA;
+	driver->format = config->native_rgb565 ? NGL_RGB_565 : NGL_RGBA;
+	ngl_driver_init(driver);
+	driver_priv->native = config->native_rgb565;
 	driver_priv->buffer_size = driver->width * config->buffer_lines * 4;
 	driver_priv->buffer_lines = config->buffer_lines;
-	driver_priv->buffer.area.x = 0;
-	driver_priv->buffer.area.y = driver->height - config->buffer_lines;
-	driver_priv->buffer.area.width = driver->width;
-	driver_priv->buffer.area.height = driver->height;
-
-	driver_priv->framebuffer = heap_caps_malloc(driver_priv->buffer_size, MALLOC_CAP_DMA);
-	if (driver_priv->framebuffer == NULL) {
-		ESP_LOGE(TAG, "framebuffer not allocated");
-		free(driver->priv);
-		driver->priv = NULL;
-		return ESP_FAIL;
+	ngl_area_t screen = {0, 0, driver->width, driver->height};
+	ngl_buffer_init(&driver_priv->buffer, &screen, NULL, driver->format, driver);
+	// Initialization sets window to whole screen
+	driver_priv->window.x = 0;
+	driver_priv->window.y = 0;
+	driver_priv->window.width = driver->width;
+	driver_priv->window.height = driver->height;
+	driver_priv->window_row = 0;
+	driver_priv->bands = NULL;
+	driver_priv->band_count = 1;
+	driver_priv->band_head = 0;
+	driver_priv->band_tail = 0;
+	driver_priv->render_task = NULL;
+	driver_priv->flush_task = NULL;
+	driver_priv->stop = false;
+	driver_priv->calibration_frames = 0;
+	driver_priv->calibration_frame_bands = 0;
+	driver_priv->calibrated = false;
+	driver_priv->pixels_converted = 0;
+	// Native mode has nothing to convert
+	if (config->pipeline_bands > 1 && !driver_priv->native) {
+		driver_priv->band_count = config->pipeline_bands;
+	}
+
+	if (driver_priv->native) {
+		// Buffer is replaced by current DMA buffer in get_window
+		driver_priv->framebuffer = NULL;
+	}
+	else {
+		driver_priv->framebuffer = st7789_ngl_driver_alloc(&storage, driver_priv->buffer_size * driver_priv->band_count, MALLOC_CAP_DMA);
+		if (driver_priv->framebuffer == NULL) {
+			ESP_LOGE(TAG, "framebuffer not allocated");
+			st7789_ngl_driver_free(driver);
+			return ESP_FAIL;
+		}
+	}
+
+	StaticTask_t *flush_task_buffer = NULL;
+	StackType_t *flush_task_stack = NULL;
+	if (driver_priv->band_count > 1) {
+		driver_priv->bands = (st7789_ngl_driver_band_t *)st7789_ngl_driver_alloc(&storage, sizeof(st7789_ngl_driver_band_t) * driver_priv->band_count, MALLOC_CAP_DEFAULT);
+		if (driver_priv->bands == NULL) {
+			ESP_LOGE(TAG, "bands not allocated");
+			st7789_ngl_driver_free(driver);
+			return ESP_FAIL;
+		}
+		for (size_t i = 0; i < driver_priv->band_count; ++i) {
+			driver_priv->bands[i].buffer = driver_priv->framebuffer + i * driver_priv->buffer_size;
+		}
+		if (driver_priv->static_storage) {
+			flush_task_buffer = (StaticTask_t *)st7789_ngl_driver_alloc(&storage, sizeof(StaticTask_t), MALLOC_CAP_DEFAULT);
+			flush_task_stack = (StackType_t *)st7789_ngl_driver_alloc(&storage, ST7789_NGL_DRIVER_FLUSH_STACK_SIZE * sizeof(StackType_t), MALLOC_CAP_DEFAULT);
+		}
 	}
 
 	driver_priv->buffer.buffer = driver_priv->framebuffer;
@@ -177,9 +461,17 @@ esp_err_t st7789_ngl_driver_init(ngl_driver_t *driver, st7789_ngl_driver_init_st
 	driver_priv->display.buffer_count = config->buffer_count;
 	driver_priv->display.dither = true;
 
-	if (st7789_init(&driver_priv->display) != ESP_OK) {
-		free(driver_priv->framebuffer);
-		free(driver_priv);
+	esp_err_t status;
+	if (driver_priv->static_storage) {
+		// Display gets rest of storage
+		status = st7789_init_static(&driver_priv->display, storage, storage_size - (storage - storage_start));
+	}
+	else {
+		status = st7789_init(&driver_priv->display);
+	}
+	if (status != ESP_OK) {
+		driver_priv->display.framebuffers = NULL;
+		st7789_ngl_driver_free(driver);
 		return ESP_FAIL;
 	}
 
@@ -187,23 +479,188 @@ esp_err_t st7789_ngl_driver_init(ngl_driver_t *driver, st7789_ngl_driver_init_st
 	st7789_lcd_init(&driver_priv->display);
 	st7789_wait_until_queue_empty(&driver_priv->display);
 
+	if (driver_priv->bands != NULL) {
+		// Conversion runs on last core with priority over rendering
+		driver_priv->render_task = xTaskGetCurrentTaskHandle();
+		if (driver_priv->static_storage) {
+			driver_priv->flush_task = xTaskCreateStaticPinnedToCore(&st7789_ngl_driver_flush_task, "st7789_flush", ST7789_NGL_DRIVER_FLUSH_STACK_SIZE, driver, uxTaskPriorityGet(NULL) + 1, flush_task_stack, flush_task_buffer, portNUM_PROCESSORS - 1);
+		}
+		else if (xTaskCreatePinnedToCore(&st7789_ngl_driver_flush_task, "st7789_flush", ST7789_NGL_DRIVER_FLUSH_STACK_SIZE, driver, uxTaskPriorityGet(NULL) + 1, &driver_priv->flush_task, portNUM_PROCESSORS - 1) != pdPASS) {
+			driver_priv->flush_task = NULL;
+		}
+		if (driver_priv->flush_task == NULL) {
+			ESP_LOGW(TAG, "flush task not created, pipeline disabled");
+			if (!driver_priv->static_storage) {
+				heap_caps_free(driver_priv->bands);
+			}
+			driver_priv->bands = NULL;
+			driver_priv->band_count = 1;
+		}
+	}
+
+	driver_priv->capacity_lines = config->buffer_lines;
+	driver_priv->capacity_count = config->buffer_count;
+	driver_priv->capacity_bands = driver_priv->band_count;
+
 	return ESP_OK;
 }
 
 
+esp_err_t st7789_ngl_driver_init(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config) {
+	return st7789_ngl_driver_init_storage(driver, config, NULL, 0);
+}
+
+
+esp_err_t st7789_ngl_driver_init_static(ngl_driver_t *driver, st7789_ngl_driver_init_struct_t *config, void *storage, size_t storage_size) {
+	if (storage_size < ST7789_NGL_DRIVER_STORAGE_SIZE(config->width, config->buffer_lines, config->buffer_count, config->native_rgb565, config->pipeline_bands)) {
+		ESP_LOGE(TAG, "storage too small");
+		driver->priv = NULL;
+		return ESP_ERR_INVALID_SIZE;
+	}
+	return st7789_ngl_driver_init_storage(driver, config, (uint8_t *)storage, storage_size);
+}
+
+
 esp_err_t st7789_ngl_driver_destroy(ngl_driver_t *driver) {
 	st7789_ngl_driver_priv_t *driver_priv = driver->priv;
 	if (driver_priv != NULL) {
+		st7789_ngl_driver_stop_pipeline(driver_priv);
 		if (driver_priv->display.framebuffers != NULL) {
 			st7789_wait_until_queue_empty(&driver_priv->display);
 			st7789_destroy(&driver_priv->display);
 		}
-		if (driver_priv->framebuffer != NULL) {
-			free(driver_priv->framebuffer);
-			driver_priv->framebuffer = NULL;
+		st7789_ngl_driver_free(driver);
+		ngl_driver_destroy(driver);
+	}
+
+	return ESP_OK;
+}
+
+
+esp_err_t st7789_ngl_driver_calibrate(ngl_driver_t *driver, int frames, size_t ram_budget) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	if (frames < 2) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if (driver_priv->calibration_frames > 0) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	memset(driver_priv->samples, 0, sizeof(driver_priv->samples));
+	driver_priv->calibrated = false;
+	driver_priv->calibration_lines = driver_priv->buffer_lines;
+	driver_priv->calibration_frame_bands = 0;
+	driver_priv->calibration_budget = ram_budget;
+	__atomic_store_n(&driver_priv->calibration_frames, frames, __ATOMIC_RELEASE);
+	ngl_invalidate(driver);
+	return ESP_OK;
+}
+
+
+esp_err_t st7789_ngl_driver_get_calibration(ngl_driver_t *driver, st7789_ngl_driver_calibration_t *calibration) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	if (!driver_priv->calibrated) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	calibration->render = st7789_ngl_driver_fit(&driver_priv->samples[ST7789_NGL_DRIVER_RENDER]);
+	calibration->convert = st7789_ngl_driver_fit(&driver_priv->samples[ST7789_NGL_DRIVER_CONVERT]);
+	calibration->transfer = st7789_ngl_driver_fit(&driver_priv->samples[ST7789_NGL_DRIVER_TRANSFER]);
+	calibration->bands = driver_priv->samples[ST7789_NGL_DRIVER_RENDER].count;
+	return ESP_OK;
+}
+
+
+float st7789_ngl_driver_estimate(ngl_driver_t *driver, const st7789_ngl_driver_calibration_t *calibration, const st7789_ngl_driver_bands_t *bands) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	const int band_count = (driver->height + bands->buffer_lines - 1) / bands->buffer_lines;
+	const float pixels = driver->width * bands->buffer_lines;
+	const float render = calibration->render.band + calibration->render.pixel * pixels;
+	const float convert = driver_priv->native ? 0.0f : calibration->convert.band + calibration->convert.pixel * pixels;
+	const float transfer = calibration->transfer.band + calibration->transfer.pixel * pixels;
+	// Two DMA buffers are sent one by one, more buffers let transfer run while next band is prepared
+	const bool overlap = bands->buffer_count > 2;
+
+	float slowest;
+	if (bands->pipeline_bands > 1 && !driver_priv->native) {
+		// Rendering runs on other core than conversion
+		const float send = overlap ? MAX(convert, transfer) : convert + transfer;
+		slowest = MAX(render, send);
+	}
+	else {
+		slowest = overlap ? MAX(render + convert, transfer) : render + convert + transfer;
+	}
+	// Slowest stage limits throughput, other stages fill and drain pipeline once
+	return band_count * slowest + (render + convert + transfer - slowest);
+}
+
+
+size_t st7789_ngl_driver_bands_memory(ngl_driver_t *driver, const st7789_ngl_driver_bands_t *bands) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	const size_t line_pixels = driver->width * bands->buffer_lines;
+	size_t size = line_pixels * sizeof(st7789_color_t) * bands->buffer_count;
+	if (!driver_priv->native) {
+		size += line_pixels * sizeof(ngl_color_t) * MAX(bands->pipeline_bands, 1);
+	}
+	return size;
+}
+
+
+esp_err_t st7789_ngl_driver_tune(ngl_driver_t *driver, const st7789_ngl_driver_calibration_t *calibration, size_t ram_budget, st7789_ngl_driver_bands_t *bands) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	float best_time = 0;
+	size_t best_memory = 0;
+	bool found = false;
+
+	st7789_ngl_driver_bands_t candidate;
+	for (candidate.buffer_lines = 1; candidate.buffer_lines <= driver_priv->capacity_lines; ++candidate.buffer_lines) {
+		for (candidate.buffer_count = 2; candidate.buffer_count <= driver_priv->capacity_count; ++candidate.buffer_count) {
+			for (candidate.pipeline_bands = 1; candidate.pipeline_bands <= driver_priv->capacity_bands; ++candidate.pipeline_bands) {
+				const size_t memory = st7789_ngl_driver_bands_memory(driver, &candidate);
+				if (memory > ram_budget) {
+					continue;
+				}
+				// Layouts faster by less than microsecond are not worth more memory
+				const float time = st7789_ngl_driver_estimate(driver, calibration, &candidate);
+				if (!found || time < best_time - 1.0f || (time <= best_time + 1.0f && memory < best_memory)) {
+					*bands = candidate;
+					best_time = time;
+					best_memory = memory;
+					found = true;
+				}
+			}
 		}
-		free(driver_priv);
 	}
+	return found ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
 
+
+void st7789_ngl_driver_get_bands(ngl_driver_t *driver, st7789_ngl_driver_bands_t *bands) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	bands->buffer_lines = driver_priv->buffer_lines;
+	bands->buffer_count = driver_priv->display.buffer_count;
+	bands->pipeline_bands = driver_priv->band_count;
+}
+
+
+esp_err_t st7789_ngl_driver_set_bands(ngl_driver_t *driver, const st7789_ngl_driver_bands_t *bands) {
+	st7789_ngl_driver_priv_t *driver_priv = (st7789_ngl_driver_priv_t *)driver->priv;
+	if (driver_priv->calibration_frames > 0) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	// Buffers, SPI queue and maximum transfer are sized by init
+	if (bands->buffer_lines < 1 || bands->buffer_lines > driver_priv->capacity_lines ||
+		bands->buffer_count < 2 || bands->buffer_count > driver_priv->capacity_count ||
+		bands->pipeline_bands < 1 || bands->pipeline_bands > driver_priv->capacity_bands) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	st7789_ngl_driver_sync(driver_priv);
+	st7789_wait_until_queue_empty(&driver_priv->display);
+	driver_priv->buffer_lines = bands->buffer_lines;
+	driver_priv->display.buffer_size = driver->width * bands->buffer_lines;
+	driver_priv->display.buffer_count = bands->buffer_count;
+	driver_priv->display.current_buffer_num = 0;
+	driver_priv->display.current_buffer = driver_priv->display.framebuffers[0];
+	// Ring positions stay valid, ring is empty
+	driver_priv->band_count = bands->pipeline_bands;
 	return ESP_OK;
 }
@@ -364,7 +364,7 @@ static void destroy_resources(ngl_driver_t *driver) {
 	destroy_buffer(window->vertex_buffer);
 }
 
-static ngl_buffer_t *simulator_display_get_buffer(ngl_driver_t *driver) {
+static ngl_buffer_t *simulator_display_get_window(ngl_driver_t *driver, ngl_area_t *area) {
 	simulator_window_t *window = (simulator_window_t *)driver->priv;
 
 	if (window->pixel_buffer_data == NULL) {
@@ -375,33 +375,40 @@ static ngl_buffer_t *simulator_display_get_buffer(ngl_driver_t *driver) {
 		if (window->pixel_buffer_data == NULL) {
 			ESP_LOGE(TAG, "Pixel buffer not mapped");
 		}
-		window->current_buffer.buffer = window->pixel_buffer_data;
-		window->current_buffer.area.y = 0;
-		window->current_buffer.area.height = window->buffer_lines;
 	}
-	else if (window->pixel_buffer_data != NULL) {
-		if (window->current_buffer.area.y + window->current_buffer.area.height >= driver->height) {
-			window->current_buffer.area.y = 0;
-		}
-		else {
-			window->current_buffer.area.y += window->buffer_lines;
-		}
 
-		size_t pixel_size = ngl_get_color_bits(driver->format) >> 3;
-		size_t buffer_offset = driver->width * window->current_buffer.area.y * pixel_size;
-		size_t screen_size = driver->width * driver->height * pixel_size;
-		size_t line_size = driver->width * pixel_size;
-		window->current_buffer.buffer = window->pixel_buffer_data + buffer_offset;
-		int buffer_height = (screen_size - buffer_offset) / line_size;
-		if (buffer_height > window->buffer_lines) {
-			buffer_height = window->buffer_lines;
-		}
-		window->current_buffer.area.height = buffer_height;
+	// Window is view into whole screen, lines keep stride of screen
+	size_t pixel_size = ngl_get_color_bits(driver->format) >> 3;
+	size_t buffer_offset = (driver->width * area->y + area->x) * pixel_size;
+	int buffer_height = driver->height - area->y;
+	if (buffer_height > area->height) {
+		buffer_height = area->height;
+	}
+	if (buffer_height > window->buffer_lines) {
+		buffer_height = window->buffer_lines;
 	}
+	window->current_buffer.buffer = window->pixel_buffer_data + buffer_offset;
+	window->current_buffer.stride = driver->width;
+	window->current_buffer.area.x = area->x;
+	window->current_buffer.area.y = area->y;
+	window->current_buffer.area.width = area->width;
+	window->current_buffer.area.height = buffer_height;
 
 	return &window->current_buffer;
 }
 
+static ngl_buffer_t *simulator_display_get_buffer(ngl_driver_t *driver) {
+	simulator_window_t *window = (simulator_window_t *)driver->priv;
+
+	ngl_area_t area = {0, 0, driver->width, driver->height};
+	if (window->pixel_buffer_data != NULL && window->current_buffer.area.y + window->current_buffer.area.height < driver->height) {
+		area.y = window->current_buffer.area.y + window->current_buffer.area.height;
+		area.height -= area.y;
+	}
+
+	return simulator_display_get_window(driver, &area);
+}
+
 static void simulator_graphic_process_events(TimerHandle_t timer) {
 	xSemaphoreTake(gl_mutex, portMAX_DELAY);
 	glutMainLoopEvent();
@@ -418,24 +425,22 @@ static void simulator_graphic_process_events(TimerHandle_t timer) {
 }
 
 static void simulator_display_flush(ngl_driver_t *driver) {
+	// Pixels are rendered directly to mapped pixel buffer
+}
+
+static void simulator_display_end_frame(ngl_driver_t *driver) {
 	simulator_window_t *window = (simulator_window_t *)driver->priv;
-	GLboolean finished = GL_FALSE;
 
-	if (window->current_buffer.area.y + window->buffer_lines >= driver->height) {
-		if (window->pixel_buffer_data != NULL) {
-			xSemaphoreTake(gl_mutex, portMAX_DELAY);
-			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, window->pixel_buffer);
-			xSemaphoreGive(gl_mutex);
-			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-			window->pixel_buffer_data = NULL;
-			window->current_buffer.buffer = NULL;
-		}
-		finished = GL_TRUE;
-	}
-	if (finished) {
-		simulator_graphic_process_events(process_graphic_events_timer);
-		vTaskDelay(20 / portTICK_PERIOD_MS);
+	if (window->pixel_buffer_data != NULL) {
+		xSemaphoreTake(gl_mutex, portMAX_DELAY);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, window->pixel_buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		xSemaphoreGive(gl_mutex);
+		window->pixel_buffer_data = NULL;
+		window->current_buffer.buffer = NULL;
 	}
+	// Frame rate is limited by scheduler
+	simulator_graphic_process_events(process_graphic_events_timer);
 }
 
 static void simulator_graphic_init(void) {
@@ -484,7 +489,6 @@ void simulator_display_init(ngl_driver_t *driver, int width, int height, ngl_col
 
 	simulator_graphic_init();
 	xSemaphoreTake(gl_mutex, portMAX_DELAY);
-	driver->frame = 0;
 	driver->priv = malloc(sizeof(simulator_window_t));
 	if (driver->priv == NULL) {
 		ESP_LOGE(TAG, "Simulator window not allocated");
@@ -498,6 +502,10 @@ void simulator_display_init(ngl_driver_t *driver, int width, int height, ngl_col
 	driver->format = format;
 	driver->flush = simulator_display_flush;
 	driver->get_buffer = simulator_display_get_buffer;
+	driver->get_window = simulator_display_get_window;
+	driver->end_frame = simulator_display_end_frame;
+	driver->get_stats = NULL;
+	ngl_driver_init(driver);
 
 	size_t pixel_size = ngl_get_color_bits(format) >> 3;
 	assert(buffer_size >= width * pixel_size);
@@ -505,12 +513,8 @@ void simulator_display_init(ngl_driver_t *driver, int width, int height, ngl_col
 	window->buffer_lines = buffer_size / (width * pixel_size);
 
 	window->pixel_buffer_data = NULL;
-	window->current_buffer.buffer = NULL;
-	window->current_buffer.area.x = 0;
-	window->current_buffer.area.y = 0;
-	window->current_buffer.area.width = width;
-	window->current_buffer.area.height = window->buffer_lines;
-	window->current_buffer.format = driver->format;
+	ngl_area_t buffer_area = {0, 0, width, window->buffer_lines};
+	ngl_buffer_init(&window->current_buffer, &buffer_area, NULL, driver->format, driver);
 
 	glutInitWindowSize(width * 2, height * 2);
 	window->glut_window = glutCreateWindow("simulator");
@@ -553,6 +557,8 @@ void simulator_display_destroy(ngl_driver_t *driver) {
 		window_unregister(driver);
 		glutDestroyWindow(window->glut_window);
 		free(driver->priv);
+		driver->priv = NULL;
+		ngl_driver_destroy(driver);
 	}
 
 	xSemaphoreGive(gl_mutex);
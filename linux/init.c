@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -9,6 +10,16 @@
 #include "display.h"
 #include "gui.h"
 #include "init.h"
+#include "nanogl/executor_posix.h"
+#include "nanogl/scheduler_posix.h"
+
+
+#define DISPLAY_LIST_SIZE 256
+#define MAX_FPS 60
+#define FRAME_ARENA_SIZE 4096
+
+
+static ngl_command_t display_list_commands[DISPLAY_LIST_SIZE];
 
 
 static void gui(void *data) {
@@ -24,8 +35,30 @@ static void gui(void *data) {
 
 	simulator_display_init(&driver, 240, 240, NGL_RGBA, 240 * 240 * 2);
 
+	ngl_display_list_t display_list;
+	ngl_display_list_init(&display_list, display_list_commands, DISPLAY_LIST_SIZE);
+	driver.display_list = &display_list;
+
+	ngl_frame_arena_t frame_arena;
+	if (ngl_frame_arena_init(&frame_arena, FRAME_ARENA_SIZE, 0)) {
+		driver.arena = &frame_arena;
+	}
+
+	ngl_executor_t executor;
+	if (ngl_posix_executor_init(&executor, sysconf(_SC_NPROCESSORS_ONLN))) {
+		driver.executor = &executor;
+	}
+
+	ngl_scheduler_t scheduler;
+	if (ngl_posix_scheduler_init(&scheduler, MAX_FPS)) {
+		driver.scheduler = &scheduler;
+	}
+
 	gui_loop(&driver);
 
+	ngl_posix_scheduler_destroy(&scheduler);
+	ngl_posix_executor_destroy(&executor);
+	ngl_frame_arena_destroy(&frame_arena);
 	simulator_display_destroy(&driver);
 
 	//free(g2.buffer);
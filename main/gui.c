@@ -1,29 +1,46 @@
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
-#include <time.h>
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 
 #include "font_render.h"
 #include "gui.h"
+#include "nanogl/profile.h"
 #include "nanogl/rectangle.h"
 
-#ifndef SIMULATOR
-#include "esp_timer.h"
-#endif
+#define FONT_CACHE_SIZE 16
+// Ubuntu with hinting needs about 40 kB on host
+#define FONT_POOL_SIZE (48 * 1024)
+#define PROFILE_RECORDS 4096
+#define PROFILE_FRAMES 120
+#define STATS_FRAMES 600
 
 static const char *TAG = "gui";
 
-static long long get_us_time() {
+static uint8_t font_face_storage[FONT_FACE_STORAGE_SIZE];
+static uint8_t font_render_storage[FONT_RENDER_STORAGE_SIZE(FONT_CACHE_SIZE)];
+static uint8_t font_library_storage[FONT_LIBRARY_STORAGE_SIZE(FONT_POOL_SIZE)];
+
+#ifdef NGL_PROFILE
+static ngl_profile_record_t profile_records[PROFILE_RECORDS];
+
+/* Print summary of last frames to console, simulator writes also trace loadable to Perfetto */
+static void profile_dump(ngl_profiler_t *profiler) {
+	profiler->enabled = false;
 #ifdef SIMULATOR
-	struct timespec ts;
-	timespec_get(&ts, TIME_UTC);
-	return (long long)ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
-#else
-	return esp_timer_get_time();
+	FILE *trace = fopen("nanogl_trace.json", "w");
+	if (trace != NULL) {
+		ngl_profiler_write_trace(profiler, trace);
+		fclose(trace);
+	}
 #endif
+	ngl_profiler_write_summary(profiler, stdout);
+	ngl_profiler_clear(profiler);
+	profiler->enabled = true;
 }
+#endif
 
 extern const char *_binary_Ubuntu_R_ttf_start;
 extern const size_t Ubuntu_R_ttf_length;
@@ -31,16 +48,24 @@ extern const size_t Ubuntu_R_ttf_length;
 #include "font_cache.h"
 
 void gui_loop(ngl_driver_t *driver) {
+	// Glyph bitmaps are allocated by FreeType on every placement, pool keeps them off heap
+	if (font_library_init_static(font_library_storage, sizeof(font_library_storage)) != ESP_OK) {
+		ESP_LOGE(TAG, "Font library not initialized");
+		return;
+	}
+
 	font_face_t ubuntu_font;
-	if (font_face_init(&ubuntu_font, _binary_Ubuntu_R_ttf_start, Ubuntu_R_ttf_length) != ESP_OK) {
+	if (font_face_init_static(&ubuntu_font, _binary_Ubuntu_R_ttf_start, Ubuntu_R_ttf_length, font_face_storage, sizeof(font_face_storage)) != ESP_OK) {
 		ESP_LOGE(TAG, "Font not initialized");
+		font_library_destroy();
 		return;
 	}
 
 	font_render_t ubuntu_font_16;
-	if (font_render_init(&ubuntu_font_16, &ubuntu_font, 16, 16) != ESP_OK) {
+	if (font_render_init_static(&ubuntu_font_16, &ubuntu_font, 16, FONT_CACHE_SIZE, font_render_storage, sizeof(font_render_storage)) != ESP_OK) {
 		ESP_LOGE(TAG, "Font render not initialized");
 		font_face_destroy(&ubuntu_font);
+		font_library_destroy();
 		return;
 	}
 
@@ -76,22 +101,84 @@ void gui_loop(ngl_driver_t *driver) {
 	);
 
 	ngl_widget_t *screen[] = {&rectangle};
+
+#ifdef NGL_PROFILE
+	ngl_profiler_t profiler;
+	ngl_profiler_init(&profiler, profile_records, PROFILE_RECORDS);
+	ngl_profiler_label(&profiler, &rectangle, "rectangle");
+	driver->profiler = &profiler;
+#endif
+
 	while (1) {
 		font_pos_t pos = {0, 0};
 		font_glyph_placement_t place = font_place_glyph(&ubuntu_font_16, 'L', &pos, NULL);
+		// Sleep until something changes
+		if (!ngl_wait_frame(driver)) {
+			continue;
+		}
+		ngl_draw_frame(driver, screen, sizeof(screen) / sizeof(ngl_widget_t *));
+		// Only drawn frames are counted
 		frame++;
-		//uint64_t us_before_frame = get_us_time();
-		//ngl_draw_frame(driver, screen, sizeof(screen) / sizeof(ngl_widget_t *));
+
+		// Arena and font pool are sized from their high water marks in this log
+		if (frame % STATS_FRAMES == 0) {
+			ngl_stats_t stats;
+			font_library_stats_t font_stats;
+			font_cache_stats_t glyph_stats;
+			ngl_get_stats(driver, &stats);
+			font_library_get_stats(&font_stats);
+			font_render_get_cache_stats(&ubuntu_font_16, &glyph_stats);
+			ESP_LOGI(
+				TAG,
+				"frames %" PRIu32 ", skipped %" PRIu32 ", bands %" PRIu32 ", widget cache %" PRIu32 " hits %" PRIu32 " misses",
+				stats.frames,
+				stats.frames_skipped,
+				stats.bands,
+				stats.cache_hits,
+				stats.cache_misses
+			);
+			ESP_LOGI(
+				TAG,
+				"converted %" PRIu32 " pixels, bus %" PRIu32 " bytes, queue wait %" PRIu32 " us",
+				stats.pixels_converted,
+				stats.bus_bytes,
+				stats.queue_wait_us
+			);
+			ESP_LOGI(
+				TAG,
+				"arena %zu of %zu bytes, %zu failed allocations",
+				stats.arena_high_water,
+				stats.arena_size,
+				stats.arena_failures
+			);
+			ESP_LOGI(
+				TAG,
+				"glyph cache %" PRIu32 " hits %" PRIu32 " misses, font pool %zu of %d bytes, %zu failed allocations",
+				glyph_stats.hits,
+				glyph_stats.misses,
+				font_stats.high_water,
+				FONT_POOL_SIZE,
+				font_stats.failures
+			);
+		}
 		//bool found;
 		//for (size_t i = 0; i < 500; ++i) {
 		//	void *data = font_cache_get(&font_cache, i & 0x03, &found);
 		//	printf("%ld %p\n", i & 0x03, data);
 		//}
 
-		//uint64_t us_after_frame = get_us_time();
-		//printf("f: %08ld, time: %.4f ms\n", frame, (double)(us_after_frame - us_before_frame) / 1000.);
+#ifdef NGL_PROFILE
+		if (frame % PROFILE_FRAMES == 0) {
+			profile_dump(&profiler);
+		}
+#endif
 	}
 
+#ifdef NGL_PROFILE
+	driver->profiler = NULL;
+#endif
+
 	font_render_destroy(&ubuntu_font_16);
 	font_face_destroy(&ubuntu_font);
+	font_library_destroy();
 }
@@ -9,6 +9,8 @@
 
 #include "gui.h"
 #include "init.h"
+#include "nanogl/executor_freertos.h"
+#include "nanogl/scheduler_freertos.h"
 #include "st7789_ngl_driver.h"
 
 
@@ -21,27 +23,79 @@
 #define ST7789_DISPLAY_WIDTH 240
 #define ST7789_DISPLAY_HEIGHT 240
 #define ST7789_BUFFER_SIZE 20
+#define ST7789_BUFFER_COUNT 3
+#define ST7789_NATIVE_RGB565 true
+#define ST7789_CALIBRATION_FRAMES 16
+// Band buffers of tuned layout, less than 3 buffers of 20 lines reserved in storage
+#define ST7789_RAM_BUDGET (16 * 1024)
+#define DISPLAY_LIST_SIZE 64
+#define MAX_FPS 60
+#define FRAME_ARENA_SIZE 4096
+#define SWEEP_CAPACITY 16
+#define EXECUTOR_WORKERS portNUM_PROCESSORS
+#define GUI_STACK_SIZE (configMINIMAL_STACK_SIZE + 2048)
+
+
+// All memory of drawing is reserved at build time
+static ngl_command_t display_list_commands[DISPLAY_LIST_SIZE];
+static uint8_t display_storage[ST7789_NGL_DRIVER_STORAGE_SIZE(ST7789_DISPLAY_WIDTH, ST7789_BUFFER_SIZE, ST7789_BUFFER_COUNT, ST7789_NATIVE_RGB565, 0)];
+static ngl_byte_t frame_arena_data[FRAME_ARENA_SIZE];
+static uint8_t sweep_storage[NGL_SWEEP_STORAGE_SIZE(SWEEP_CAPACITY)];
+static uint8_t executor_storage[NGL_FREERTOS_EXECUTOR_STORAGE_SIZE(EXECUTOR_WORKERS)];
+static uint8_t scheduler_storage[NGL_FREERTOS_SCHEDULER_STORAGE_SIZE];
+static StackType_t gui_stack[GUI_STACK_SIZE];
+static StaticTask_t gui_task;
 
 
 void gui(void *data) {
 	ngl_driver_t driver;
 	st7789_ngl_driver_init_struct_t ngl_init = {
-		.pin_reset=GPIO_NUM_19,
-		.pin_dc=GPIO_NUM_22,
-		.pin_mosi=GPIO_NUM_23,
-		.pin_sclk=GPIO_NUM_18,
-		.spi_host=VSPI_HOST,
-		.dma_chan=2,
-		.width=240,
-		.height=240,
-		.buffer_lines=20,
-		.buffer_count=3,
+		.pin_reset=ST7789_GPIO_RESET,
+		.pin_dc=ST7789_GPIO_DC,
+		.pin_mosi=ST7789_GPIO_MOSI,
+		.pin_sclk=ST7789_GPIO_SCLK,
+		.spi_host=ST7789_SPI_HOST,
+		.dma_chan=ST7789_DMA_CHAN,
+		.width=ST7789_DISPLAY_WIDTH,
+		.height=ST7789_DISPLAY_HEIGHT,
+		.buffer_lines=ST7789_BUFFER_SIZE,
+		.buffer_count=ST7789_BUFFER_COUNT,
+		.native_rgb565=ST7789_NATIVE_RGB565,
 	};
 
-	ESP_ERROR_CHECK(st7789_ngl_driver_init(&driver, &ngl_init));
+	ESP_ERROR_CHECK(st7789_ngl_driver_init_static(&driver, &ngl_init, display_storage, sizeof(display_storage)));
+	ngl_driver_set_sweep_storage(&driver, sweep_storage, SWEEP_CAPACITY);
+	// Band height and buffer count are tuned to widgets during first frames, storage only bounds layouts which are tried
+	ESP_ERROR_CHECK(st7789_ngl_driver_calibrate(&driver, ST7789_CALIBRATION_FRAMES, ST7789_RAM_BUDGET));
+
+	ngl_display_list_t display_list;
+	ngl_display_list_init(&display_list, display_list_commands, DISPLAY_LIST_SIZE);
+	driver.display_list = &display_list;
+
+	ngl_frame_arena_t frame_arena;
+	ngl_frame_arena_init_static(&frame_arena, frame_arena_data, FRAME_ARENA_SIZE);
+	driver.arena = &frame_arena;
+
+	ngl_executor_t executor;
+	if (ngl_freertos_executor_init_static(&executor, EXECUTOR_WORKERS, executor_storage, sizeof(executor_storage))) {
+		driver.executor = &executor;
+	}
+
+	ngl_scheduler_t scheduler;
+	if (ngl_freertos_scheduler_init_static(&scheduler, MAX_FPS, scheduler_storage, sizeof(scheduler_storage))) {
+		driver.scheduler = &scheduler;
+	}
 
 	gui_loop(&driver);
 
+	// Failed init leaves drawing on calling task and structure uninitialized
+	if (driver.scheduler != NULL) {
+		ngl_freertos_scheduler_destroy(&scheduler);
+	}
+	if (driver.executor != NULL) {
+		ngl_freertos_executor_destroy(&executor);
+	}
+	ngl_frame_arena_destroy(&frame_arena);
 	ESP_ERROR_CHECK(st7789_ngl_driver_destroy(&driver));
 
 	vTaskDelete(NULL);
@@ -49,5 +103,5 @@ void gui(void *data) {
 
 
 void app_init(void) {
-	xTaskCreate(&gui, "gui", configMINIMAL_STACK_SIZE + 2048, NULL, tskIDLE_PRIORITY + 1, NULL);
+	xTaskCreateStatic(&gui, "gui", GUI_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, gui_stack, &gui_task);
 }